@@ -69,7 +69,7 @@ endif
 all: polybuild$(out_ext)
 .PHONY: all
 
-obj/main_0$(obj_ext): ./main.cpp .polybuild.mk ./toml.hpp ./toml/parser.hpp ./toml/combinator.hpp ./toml/region.hpp ./toml/color.hpp ./toml/result.hpp ./toml/traits.hpp ./toml/from.hpp ./toml/into.hpp ./toml/version.hpp ./toml/utility.hpp ./toml/lexer.hpp ./toml/macros.hpp ./toml/types.hpp ./toml/comments.hpp ./toml/datetime.hpp ./toml/string.hpp ./toml/value.hpp ./toml/exception.hpp ./toml/source_location.hpp ./toml/storage.hpp ./toml/literal.hpp ./toml/serializer.hpp ./toml/get.hpp ./util.hpp
+obj/main_0$(obj_ext): ./main.cpp .polybuild.mk ./toml.hpp ./toml/parser.hpp ./toml/arena.hpp ./toml/region.hpp ./toml/color.hpp ./toml/scan.hpp ./toml/storage.hpp ./toml/utility.hpp ./toml/traits.hpp ./toml/from.hpp ./toml/into.hpp ./toml/version.hpp ./toml/value.hpp ./toml/comments.hpp ./toml/exception.hpp ./toml/source_location.hpp ./toml/types.hpp ./toml/datetime.hpp ./toml/flat_map.hpp ./toml/string.hpp ./toml/combinator.hpp ./toml/result.hpp ./toml/lexer.hpp ./toml/macros.hpp ./toml/literal.hpp ./toml/serializer.hpp ./toml/get.hpp ./toml/lazy.hpp ./toml/binding.hpp ./toml/events.hpp ./util.hpp
 	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Compiling $@ from $<..."
 	@mkdir -p obj
 	@$(cpp_compiler) $(compile_only_flag) $< $(cpp_compilation_flags) $(obj_path_flag)$@
@@ -0,0 +1,571 @@
+#include "toml.hpp"
+#include "util.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/resource.h>
+    #include <unistd.h>
+#endif
+
+// Benchmarks for Polybuild, run from this directory after building Polybuild itself:
+// the generator end to end on synthetic source trees, the #include scanner on one of them, and the vendored toml parser on synthetic documents
+
+std::string log(const std::string& str) {
+    return "\033[1m[POLYBUILD-BENCH]\033[0m " + str;
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Runs the fastest of several repetitions of a function and returns its time in seconds
+template <typename F>
+double best_of(unsigned int repeat, F&& f) {
+    double best = 0.;
+    for (unsigned int i = 0; i < repeat; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        if (double time = seconds_since(start); i == 0 || time < best) {
+            best = time;
+        }
+    }
+    return best;
+}
+
+struct ProcessStats {
+    int status = -1;
+    double time = 0.;
+    long peak_rss = -1; // In KiB, or -1 where it can't be measured
+};
+
+// Like run_process, but also measures the wall time and peak resident set size of the process, whose output is discarded
+ProcessStats run_measured_process(const std::vector<std::string>& arguments) {
+    ProcessStats stats;
+    auto start = std::chrono::steady_clock::now();
+#ifdef _WIN32
+    stats.status = run_process(arguments);
+#else
+    std::vector<char*> argv;
+    for (const auto& argument : arguments) {
+        argv.push_back((char*) argument.c_str());
+    }
+    argv.push_back(nullptr);
+
+    posix_spawn_file_actions_t file_actions;
+    posix_spawn_file_actions_init(&file_actions);
+    posix_spawn_file_actions_addopen(&file_actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+
+    pid_t pid;
+    int spawn_error = posix_spawnp(&pid, argv[0], &file_actions, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&file_actions);
+    if (spawn_error != 0) {
+        return stats;
+    }
+
+    int status;
+    struct rusage usage;
+    while (wait4(pid, &status, 0, &usage) == -1) {
+        if (errno != EINTR) {
+            return stats;
+        }
+    }
+    stats.status = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+    #ifdef __APPLE__
+    stats.peak_rss = usage.ru_maxrss / 1024; // Bytes on macOS
+    #else
+    stats.peak_rss = usage.ru_maxrss;
+    #endif
+#endif
+    stats.time = seconds_since(start);
+    return stats;
+}
+
+// The shape of a synthetic source tree
+// Every source includes fan_out headers of the first level, and every header includes fan_out headers of the next level, down to depth levels
+struct TreeShape {
+    size_t files;
+    unsigned int fan_out;
+    unsigned int depth;
+    unsigned int headers_per_level;
+    bool has_common_stems; // Whether sources share a few names, like util.cpp, in directories of their own, rather than each having a name of its own
+};
+
+std::string header_path(unsigned int level, size_t index) {
+    return "l" + std::to_string(level) + "/h" + std::to_string(index) + ".hpp";
+}
+
+// Writes some text that looks like code without #include directives, which the scanner has to skip
+void write_filler(std::ostream& os, size_t seed, unsigned int lines) {
+    for (unsigned int i = 0; i < lines; ++i) {
+        switch ((seed + i) % 4) {
+        case 0: os << "// A comment that mentions #include \"not_a_header.hpp\" " << i << '\n'; break;
+        case 1: os << "static const char* string_" << i << " = \"#include <not_a_header.hpp>\";\n"; break;
+        case 2: os << "inline int function_" << seed << '_' << i << "(int x) { return x * " << i << " + 1; }\n"; break;
+        case 3: os << "/* A block comment\n   #include \"also_not_a_header.hpp\" */\n"; break;
+        }
+    }
+}
+
+void generate_tree(const std::filesystem::path& root, const TreeShape& shape) {
+    std::filesystem::create_directories(root / "include");
+    for (unsigned int level = 0; level < shape.depth; ++level) {
+        std::filesystem::create_directories(root / "include" / ("l" + std::to_string(level)));
+        for (size_t index = 0; index < shape.headers_per_level; ++index) {
+            std::ofstream header(root / "include" / header_path(level, index));
+            header << "#pragma once\n";
+            if (level + 1 < shape.depth) {
+                for (unsigned int i = 0; i < shape.fan_out; ++i) {
+                    header << "#include \"" << header_path(level + 1, (index * shape.fan_out + i) % shape.headers_per_level) << "\"\n";
+                }
+            }
+            header << "#include <vector>\n";
+            write_filler(header, index, 16);
+        }
+    }
+
+    // Sources are spread over directories of at most 1000 files, like a large project would be
+    // With common stems, every directory instead holds one module of four sources with the same names as every other module's
+    static constexpr const char* common_stems[] = {"util", "common", "types", "main"};
+    for (size_t index = 0; index < shape.files; ++index) {
+        size_t directory_size = shape.has_common_stems ? std::size(common_stems) : 1000;
+        auto directory = root / "src" / ("d" + std::to_string(index / directory_size));
+        if (index % directory_size == 0) {
+            std::filesystem::create_directories(directory);
+        }
+        std::string stem = shape.has_common_stems ? common_stems[index % directory_size] : 's' + std::to_string(index);
+        std::ofstream source(directory / (stem + (index % 8 == 0 ? ".c" : ".cpp")));
+        for (unsigned int i = 0; i < shape.fan_out; ++i) {
+            source << "#include \"" << header_path(0, (index * shape.fan_out + i) % shape.headers_per_level) << "\"\n";
+        }
+        source << "#include <string>\n";
+        write_filler(source, index, 32);
+    }
+
+    std::ofstream config(root / "Polybuild.toml");
+    config << "[paths]\n";
+    config << "output = \"app\"\n";
+    config << "source = [\"src\"]\n";
+    config << "include = [\"include\"]\n";
+    config << "artifact = \"obj\"\n";
+    config << "recursive = true\n\n";
+    config << "[options]\n";
+    config << "compilation-flags = \"-O2\"\n";
+}
+
+// Finds #include directives the way Polybuild did before it had a scanner, matching every line against a regex
+// Unlike scan_includes, it also reports directives in comments and string literals
+size_t count_includes_with_regex(const std::string& source) {
+    const static std::regex angled_include_regex("^\\s*#\\s*include\\s*<(.+)>.*$", std::regex::optimize);
+    const static std::regex quoted_include_regex("^\\s*#\\s*include\\s*\"(.+)\".*$", std::regex::optimize);
+
+    size_t ret = 0;
+    std::istringstream ss(source);
+    for (std::string line; std::getline(ss, line);) {
+        std::smatch matches;
+        if (std::regex_match(line, matches, quoted_include_regex) || std::regex_match(line, matches, angled_include_regex)) {
+            ++ret;
+        }
+    }
+    return ret;
+}
+
+struct TomlDocument {
+    std::string name;
+    std::string contents;
+};
+
+// Nested tables, like [t0.t1.t2], with a few keys each
+TomlDocument generate_deep_tables(size_t size) {
+    std::ostringstream ss;
+    for (size_t root = 0; (size_t) ss.tellp() < size; ++root) {
+        std::string name = "root" + std::to_string(root);
+        for (unsigned int depth = 0; depth < 16; ++depth) {
+            name += ".t" + std::to_string(depth);
+            ss << '[' << name << "]\n";
+            ss << "name = \"" << name << "\"\n";
+            ss << "depth = " << depth << '\n';
+            ss << "enabled = " << (depth % 2 ? "true" : "false") << "\n\n";
+        }
+    }
+    return {"deep tables", ss.str()};
+}
+
+// Long arrays of integers, floats and strings
+TomlDocument generate_large_arrays(size_t size) {
+    std::ostringstream ss;
+    for (size_t array = 0; (size_t) ss.tellp() < size; ++array) {
+        ss << "integers" << array << " = [";
+        for (int i = 0; i < 1000; ++i) {
+            ss << (i ? ", " : "") << i * 7919 % 100003;
+        }
+        ss << "]\nfloats" << array << " = [\n";
+        for (int i = 0; i < 1000; ++i) {
+            ss << "    " << i * 0.25 + 1e-3 << ",\n";
+        }
+        ss << "]\nstrings" << array << " = [";
+        for (int i = 0; i < 250; ++i) {
+            ss << (i ? ", " : "") << "\"item " << i << '"';
+        }
+        ss << "]\n";
+    }
+    return {"large arrays", ss.str()};
+}
+
+// Long basic, multi-line and literal strings
+TomlDocument generate_long_strings(size_t size) {
+    std::string text;
+    while (text.size() < 4096) {
+        text += "The quick brown fox jumps over the lazy dog. ";
+    }
+    std::ostringstream ss;
+    for (size_t string = 0; (size_t) ss.tellp() < size; ++string) {
+        ss << "basic" << string << " = \"" << text << "\\tescaped\\n\"\n";
+        ss << "multiline" << string << " = \"\"\"\n";
+        for (size_t i = 0; i < text.size(); i += 80) {
+            ss << text.substr(i, 80) << '\n';
+        }
+        ss << "\"\"\"\n";
+        ss << "literal" << string << " = '" << text << "'\n";
+    }
+    return {"long strings", ss.str()};
+}
+
+// Many small tables, like configuration files have, for comparing table types
+TomlDocument generate_many_tables(size_t size) {
+    std::ostringstream ss;
+    for (size_t table = 0; (size_t) ss.tellp() < size; ++table) {
+        ss << "[table" << table << "]\n";
+        for (size_t key = 0; key < 32; ++key) {
+            ss << "key" << key << " = " << table * 32 + key << '\n';
+        }
+    }
+    return {"many tables", ss.str()};
+}
+
+// A single table with many keys, written in ascending key order or shuffled, since flat_map appends keys that arrive in order but has to move the ones after a key that doesn't
+TomlDocument generate_large_table(size_t key_count, bool is_shuffled) {
+    std::vector<size_t> keys(key_count);
+    for (size_t i = 0; i < key_count; ++i) {
+        keys[i] = i;
+    }
+    if (is_shuffled) {
+        std::shuffle(keys.begin(), keys.end(), std::mt19937(key_count));
+    }
+
+    std::ostringstream ss;
+    ss << "[table]\n";
+    for (size_t key : keys) {
+        ss << "key" << std::setw(6) << std::setfill('0') << key << std::setfill(' ') << " = " << key << '\n';
+    }
+    return {"table of " + std::to_string(key_count) + " keys, " + (is_shuffled ? "shuffled" : "sorted"), ss.str()};
+}
+
+struct CountingHandler : toml::event_handler {
+    size_t values = 0;
+
+    bool on_value(const toml::value&) {
+        ++values;
+        return true;
+    }
+};
+
+template <typename Value>
+size_t lookup_all(const Value& root, const std::vector<std::pair<std::string, std::string>>& keys) {
+    size_t sum = 0;
+    for (const auto& key : keys) {
+        sum += (size_t) root.as_table().at(key.first).as_table().at(key.second).as_integer();
+    }
+    return sum;
+}
+
+void print_row(const std::string& name, double mb, double time, const std::string& extra = {}) {
+    std::cout << "  " << std::left << std::setw(34) << name << std::right << std::fixed
+              << std::setw(9) << std::setprecision(3) << time << " s"
+              << std::setw(10) << std::setprecision(1) << mb / time << " MB/s";
+    if (!extra.empty()) {
+        std::cout << "  " << extra;
+    }
+    std::cout << std::endl;
+}
+
+// Parses a document into both table types and looks up every value of every table in each, in an order that gives neither an easy walk
+bool compare_table_types(const std::filesystem::path& path, double mb, unsigned int repeat) {
+    print_row("toml::parse with flat_map", mb, best_of(repeat, [&]() {
+        toml::parse<toml::discard_comments, toml::flat_map>(path.string());
+    }));
+
+    auto hashed = toml::parse(path.string());
+    auto sorted = toml::parse<toml::discard_comments, toml::flat_map>(path.string());
+    std::vector<std::pair<std::string, std::string>> keys;
+    for (const auto& table : hashed.as_table()) {
+        for (const auto& kv : table.second.as_table()) {
+            keys.emplace_back(table.first, kv.first);
+        }
+    }
+    std::sort(keys.begin(), keys.end(), [](const auto& a, const auto& b) {
+        return std::hash<std::string>()(a.first + a.second) < std::hash<std::string>()(b.first + b.second); // Not in key order, so neither table gets an easy walk
+    });
+
+    size_t hashed_sum = 0;
+    size_t sorted_sum = 0;
+    double hashed_time = best_of(repeat, [&]() {
+        hashed_sum = lookup_all(hashed, keys);
+    });
+    double sorted_time = best_of(repeat, [&]() {
+        sorted_sum = lookup_all(sorted, keys);
+    });
+    if (hashed_sum != sorted_sum) {
+        std::cerr << log("Error: Lookups in the two table types disagree") << std::endl;
+        return false;
+    }
+    std::cout << "  " << std::left << std::setw(34) << "lookups (unordered_map, flat_map)" << std::right << std::fixed << std::setprecision(1)
+              << std::setw(9) << hashed_time * 1e9 / keys.size() << " ns"
+              << std::setw(9) << sorted_time * 1e9 / keys.size() << " ns" << std::endl;
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+#ifdef _WIN32
+    std::filesystem::path polybuild_path = "../polybuild.exe";
+#else
+    std::filesystem::path polybuild_path = "../polybuild";
+#endif
+    std::vector<size_t> file_counts = {1000, 10000, 100000};
+    TreeShape shape = {0, 4, 4, 64, false};
+    size_t toml_size = 8 << 20;
+    unsigned int repeat = 3;
+    bool keep = false;
+    bool is_running_generator = false;
+    bool is_running_scanner = false;
+    bool is_running_toml = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        auto next_number = [&]() -> unsigned long {
+            if (i + 1 == argc) {
+                throw std::invalid_argument("Missing value for " + std::string(arg));
+            }
+            return std::stoul(argv[++i]);
+        };
+
+        try {
+            if (arg == "--polybuild" && i + 1 < argc) {
+                polybuild_path = argv[++i];
+            } else if (arg == "--files" && i + 1 < argc) {
+                file_counts.clear();
+                for (std::string_view counts = argv[++i]; !counts.empty();) {
+                    size_t comma = std::min(counts.find(','), counts.size());
+                    file_counts.push_back(std::stoul(std::string(counts.substr(0, comma))));
+                    counts.remove_prefix(std::min(comma + 1, counts.size()));
+                }
+            } else if (arg == "--fan-out") {
+                shape.fan_out = next_number();
+            } else if (arg == "--depth") {
+                shape.depth = std::max(1ul, next_number());
+            } else if (arg == "--headers") {
+                shape.headers_per_level = std::max(1ul, next_number());
+            } else if (arg == "--common-stem") {
+                shape.has_common_stems = true;
+            } else if (arg == "--toml-mb") {
+                toml_size = next_number() << 20;
+            } else if (arg == "--repeat") {
+                repeat = std::max(1ul, next_number());
+            } else if (arg == "--keep") {
+                keep = true;
+            } else if (arg == "generator") {
+                is_running_generator = true;
+            } else if (arg == "scanner") {
+                is_running_scanner = true;
+            } else if (arg == "toml") {
+                is_running_toml = true;
+            } else {
+                std::cerr << log("Usage: " + std::string(argv[0]) + " [generator] [scanner] [toml] [--polybuild PATH] [--files N,...] [--fan-out N] [--depth N] [--headers N] [--common-stem] [--toml-mb N] [--repeat N] [--keep]") << std::endl;
+                return 1;
+            }
+        } catch (const std::exception&) {
+            std::cerr << log("Error: Invalid value for " + std::string(arg)) << std::endl;
+            return 1;
+        }
+    }
+
+    if (!is_running_generator && !is_running_scanner && !is_running_toml) {
+        is_running_generator = is_running_scanner = is_running_toml = true;
+    }
+
+    std::error_code ec;
+    auto work_path = std::filesystem::temp_directory_path(ec) / "polybuild-bench";
+    if (ec) {
+        work_path = std::filesystem::absolute("polybuild-bench-work");
+    }
+    std::filesystem::remove_all(work_path, ec);
+    std::filesystem::create_directories(work_path);
+
+    if (is_running_generator) {
+        polybuild_path = std::filesystem::absolute(polybuild_path);
+        if (!std::filesystem::is_regular_file(polybuild_path)) {
+            std::cerr << log("Error: Couldn't find Polybuild at " + polybuild_path.string() + " (build it first, or pass --polybuild PATH)") << std::endl;
+            return 1;
+        }
+
+        std::cout << log("Generator (fan-out " + std::to_string(shape.fan_out) + ", depth " + std::to_string(shape.depth) + ", " + std::to_string(shape.headers_per_level) + " headers per level" + (shape.has_common_stems ? ", common stems" : "") + ')') << std::endl;
+        auto original_path = std::filesystem::current_path();
+        for (size_t files : file_counts) {
+            shape.files = files;
+            auto tree_path = work_path / ("tree-" + std::to_string(files));
+            auto start = std::chrono::steady_clock::now();
+            generate_tree(tree_path, shape);
+            std::cout << "  " << files << " files (written in " << std::fixed << std::setprecision(2) << seconds_since(start) << " s)" << std::endl;
+
+            // The first run scans every source, while the second one reuses the dependency cache and only checks timestamps
+            std::filesystem::current_path(tree_path);
+            for (const char* run : {"cold", "warm"}) {
+                ProcessStats stats = run_measured_process({polybuild_path.string()});
+                if (stats.status != 0) {
+                    std::filesystem::current_path(original_path);
+                    std::cerr << log("Error: Polybuild exited with status " + std::to_string(stats.status)) << std::endl;
+                    return 1;
+                }
+                std::cout << "    " << std::left << std::setw(6) << run << std::right << std::fixed
+                          << std::setw(9) << std::setprecision(3) << stats.time << " s";
+                if (stats.peak_rss >= 0) {
+                    std::cout << std::setw(10) << std::setprecision(1) << stats.peak_rss / 1024. << " MiB peak RSS";
+                }
+                std::cout << std::endl;
+            }
+            std::filesystem::current_path(original_path);
+
+            if (!keep) {
+                std::filesystem::remove_all(tree_path, ec);
+            }
+        }
+    }
+
+    if (is_running_scanner) {
+        // The sources and headers of the smallest tree are read into memory first, so that only scanning is measured
+        shape.files = *std::min_element(file_counts.begin(), file_counts.end());
+        auto tree_path = work_path / "scanner-tree";
+        generate_tree(tree_path, shape);
+        std::vector<std::string> sources;
+        size_t size = 0;
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(tree_path)) {
+            if (entry.is_regular_file() && entry.path().filename() != "Polybuild.toml") {
+                sources.push_back(read_file(entry.path()));
+                size += sources.back().size();
+            }
+        }
+        double mb = size / 1048576.;
+
+        std::cout << log("#include scanner (best of " + std::to_string(repeat) + ", " + std::to_string(sources.size()) + " files, " + std::to_string(shape.files) + " of them sources)") << std::endl;
+        size_t regex_count = 0;
+        double regex_time = best_of(repeat, [&]() {
+            regex_count = 0;
+            for (const auto& source : sources) {
+                regex_count += count_includes_with_regex(source);
+            }
+        });
+        print_row("std::regex, line by line", mb, regex_time, std::to_string(regex_count) + " directives");
+        size_t scanner_count = 0;
+        double scanner_time = best_of(repeat, [&]() {
+            std::vector<IncludeDirective> includes;
+            for (const auto& source : sources) {
+                scan_includes(source, includes);
+            }
+            scanner_count = includes.size();
+        });
+        print_row("scan_includes", mb, scanner_time, std::to_string(scanner_count) + " directives");
+
+        if (!keep) {
+            std::filesystem::remove_all(tree_path, ec);
+        }
+    }
+
+    if (is_running_toml) {
+        std::cout << log("TOML (best of " + std::to_string(repeat) + ')') << std::endl;
+        for (auto generate : {generate_deep_tables, generate_large_arrays, generate_long_strings, generate_many_tables}) {
+            TomlDocument document = generate(toml_size);
+            std::string file_name = document.name + ".toml";
+            std::replace(file_name.begin(), file_name.end(), ' ', '-');
+            auto path = work_path / file_name;
+            if (!write_file_atomically(path, document.contents)) {
+                std::cerr << log("Error: Couldn't write " + path.string()) << std::endl;
+                return 1;
+            }
+            double mb = document.contents.size() / 1048576.;
+            std::cout << "  " << document.name << " (" << std::fixed << std::setprecision(1) << mb << " MB)" << std::endl;
+
+            print_row("toml::parse", mb, best_of(repeat, [&]() {
+                toml::parse(path.string());
+            }));
+            print_row("toml::parse into arena_value", mb, best_of(repeat, [&]() {
+                toml::parse<toml::discard_comments, toml::arena_unordered_map, toml::arena_vector>(path.string());
+            }));
+            print_row("toml::parse_lazy (structure only)", mb, best_of(repeat, [&]() {
+                toml::parse_lazy(path.string());
+            }));
+            size_t values = 0;
+            double events_time = best_of(repeat, [&]() {
+                CountingHandler handler;
+                toml::parse_events(path.string(), handler);
+                values = handler.values;
+            });
+            print_row("toml::parse_events", mb, events_time, std::to_string(values) + " values");
+
+            if (generate == generate_many_tables && !compare_table_types(path, mb, repeat)) {
+                return 1;
+            }
+        }
+
+        // Tables like those in configuration files are small, so flat_map is also compared on large ones, whose keys arrive in order or not
+        for (size_t key_count : {1000, 10000}) {
+            for (bool is_shuffled : {false, true}) {
+                TomlDocument document = generate_large_table(key_count, is_shuffled);
+                auto path = work_path / "large-table.toml";
+                if (!write_file_atomically(path, document.contents)) {
+                    std::cerr << log("Error: Couldn't write " + path.string()) << std::endl;
+                    return 1;
+                }
+                double mb = document.contents.size() / 1048576.;
+                std::cout << "  " << document.name << std::endl;
+
+                print_row("toml::parse", mb, best_of(repeat, [&]() {
+                    toml::parse(path.string());
+                }));
+                if (!compare_table_types(path, mb, repeat)) {
+                    return 1;
+                }
+            }
+        }
+
+#ifndef _WIN32
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+    #ifdef __APPLE__
+        long peak_rss = usage.ru_maxrss / 1024;
+    #else
+        long peak_rss = usage.ru_maxrss;
+    #endif
+        std::cout << "  " << std::left << std::setw(34) << "peak RSS of the TOML benchmarks" << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(9) << peak_rss / 1024. << " MiB" << std::endl;
+#endif
+    }
+
+    if (!keep) {
+        std::filesystem::remove_all(work_path, ec);
+    } else {
+        std::cout << log("Kept the generated files in " + work_path.string()) << std::endl;
+    }
+    return 0;
+}
@@ -1,14 +1,30 @@
 #include "toml.hpp"
 #include "util.hpp"
 #include <algorithm>
+#include <array>
+#include <cmath>
+#include <atomic>
+#include <chrono>
 #include <filesystem>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
-#include <regex>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <sstream>
+#include <stdlib.h>
+#include <string.h>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
+#ifndef _WIN32
+    #include <sys/utsname.h>
+#endif
 
 enum SourceFileType {
     SOURCE_FILE_C,
@@ -28,111 +44,1644 @@ SourceFileType get_source_file_type(std::filesystem::path path) {
     }
 }
 
-void find_dependencies(const std::filesystem::path& path, const std::vector<std::string>& include_paths, std::vector<std::filesystem::path>& ret) {
-    const static std::regex angled_include_regex("^\\s*#\\s*include\\s*<(.+)>.*$", std::regex::optimize);
-    const static std::regex quoted_include_regex("^\\s*#\\s*include\\s*\"(.+)\".*$", std::regex::optimize);
-
-    std::ifstream source_file(path);
-    for (std::string line; std::getline(source_file, line);) {
-        std::smatch matches;
-        if (std::regex_match(line, matches, quoted_include_regex)) {
-            // First, check locally
-            auto header_path = path.parent_path() / std::filesystem::path(std::string(matches[1]));
-            if (std::filesystem::is_regular_file(header_path)) {
-                if (std::find(ret.begin(), ret.end(), header_path) == ret.end()) {
-                    ret.push_back(header_path);
-                    find_dependencies(header_path, include_paths, ret);
-                    continue;
+// Remembers the #include directives found in each file between runs
+// Lookups are thread-safe, but each path may only be looked up once per run
+// A file is only rescanned if its modification time or size changed and its contents no longer hash the same
+class DependencyCache {
+public:
+    DependencyCache() = default;
+    explicit DependencyCache(std::filesystem::path path):
+        path(std::move(path)) {
+        std::ifstream file(this->path, std::ios::binary);
+        std::string line;
+        if (!std::getline(file, line) || line != version_line) {
+            return;
+        }
+
+        Entry* entry = nullptr;
+        while (std::getline(file, line)) {
+            if (line.size() >= 2 && line[0] == 'F' && line[1] == ' ') {
+                std::istringstream ss(line.substr(2));
+                Entry new_entry;
+                std::string entry_path;
+                if (ss >> new_entry.mtime >> new_entry.size >> new_entry.hash && ss.get() == ' ' && std::getline(ss, entry_path)) {
+                    entry = &(entries[entry_path] = std::move(new_entry));
+                } else {
+                    entry = nullptr;
+                }
+            } else if (entry && line.size() >= 3 && line[0] == 'I' && line[1] == ' ' && (line[2] == '"' || line[2] == '<')) {
+                entry->includes.push_back({line.substr(3), line[2] == '<'});
+            }
+        }
+    }
+
+    const std::vector<IncludeDirective>& includes(const std::filesystem::path& path) {
+        std::error_code ec;
+        long long mtime = std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+        uintmax_t size = ec ? 0 : std::filesystem::file_size(path, ec);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        auto [entry_it, inserted] = entries.try_emplace(path.string());
+        Entry& entry = entry_it->second;
+        if (!inserted && entry.mtime == mtime && entry.size == size) {
+            entry.used = true;
+            return entry.includes;
+        }
+        lock.unlock(); // Each file is looked up once per run, so nothing else touches this entry
+
+        std::string source = read_file(path);
+        uint64_t hash = hash_bytes(source);
+        if (inserted || entry.hash != hash || entry.size != source.size()) {
+            entry.includes.clear();
+            scan_includes(source, entry.includes);
+            entry.hash = hash;
+        }
+        entry.mtime = mtime;
+        entry.size = size;
+        entry.used = true;
+        dirty = true;
+        return entry.includes;
+    }
+
+    // Writes the cache back to disk, dropping entries for files that weren't looked at during this run
+    void save() {
+        for (auto entry_it = entries.begin(); entry_it != entries.end();) {
+            if (entry_it->second.used) {
+                ++entry_it;
+            } else {
+                entry_it = entries.erase(entry_it);
+                dirty = true;
+            }
+        }
+        if (!dirty || path.empty()) {
+            return;
+        }
+
+        std::ostringstream ss;
+        ss << version_line << '\n';
+        for (const auto& entry : entries) {
+            ss << "F " << entry.second.mtime << ' ' << entry.second.size << ' ' << entry.second.hash << ' ' << entry.first << '\n';
+            for (const auto& include : entry.second.includes) {
+                ss << "I " << (include.is_angled ? '<' : '"') << include.name << '\n';
+            }
+        }
+
+        std::error_code ec;
+        std::filesystem::create_directories(path.parent_path(), ec);
+        write_file_atomically(path, ss.str());
+        dirty = false;
+    }
+
+private:
+    static constexpr std::string_view version_line = "# Polybuild dependency cache v1";
+
+    struct Entry {
+        long long mtime = 0;
+        uintmax_t size = 0;
+        uint64_t hash = 0;
+        std::vector<IncludeDirective> includes;
+        bool used = false;
+    };
+
+    std::filesystem::path path;
+    std::mutex mutex;
+    std::unordered_map<std::string, Entry> entries;
+    std::atomic<bool> dirty = false;
+};
+
+// A list of headers that is shared by every source with the same dependencies
+typedef std::shared_ptr<const std::vector<std::filesystem::path>> DependencyList;
+
+// Caches the headers directly included by each file so that every file is read and scanned at most once per run
+// Lookups are thread-safe, so the dependencies of many sources can be found at once
+class DependencyGraph {
+public:
+    DependencyGraph(const std::vector<std::string>& include_paths, DependencyCache& cache):
+        include_paths(include_paths.begin(), include_paths.end()),
+        cache(cache) {}
+
+    // Returns every header that path transitively depends on in depth-first order
+    // Files with the same dependencies share one list, since many sources in a large project include the same headers in the same order
+    DependencyList find_dependencies(const std::filesystem::path& path) {
+        std::vector<std::filesystem::path> dependencies;
+        std::unordered_set<path_view> visited;
+        find_dependencies(path, dependencies, visited);
+
+        uint64_t hash = hash_bytes({});
+        for (const auto& dependency : dependencies) {
+            const auto& native = dependency.native();
+            hash = hash_bytes(std::string_view((const char*) native.c_str(), (native.size() + 1) * sizeof(std::filesystem::path::value_type)), hash);
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& lists = dependency_lists[hash];
+        for (const auto& list : lists) {
+            if (*list == dependencies) {
+                return list;
+            }
+        }
+        return lists.emplace_back(std::make_shared<const std::vector<std::filesystem::path>>(std::move(dependencies)));
+    }
+
+private:
+    struct Node {
+        std::once_flag scanned;
+        std::vector<std::filesystem::path> dependencies;
+    };
+
+    // Views into paths owned by nodes, which never change once a node has been scanned
+    typedef std::basic_string_view<std::filesystem::path::value_type> path_view;
+
+    std::vector<std::filesystem::path> include_paths;
+    DependencyCache& cache;
+    std::mutex mutex;
+    std::unordered_map<std::string, std::unique_ptr<Node>> nodes;
+    std::unordered_map<std::string, bool> regular_files;
+    std::unordered_map<uint64_t, std::vector<DependencyList>> dependency_lists; // Maps hashes of dependency lists to the distinct lists with each hash
+
+    void find_dependencies(const std::filesystem::path& path, std::vector<std::filesystem::path>& ret, std::unordered_set<path_view>& visited) {
+        for (const auto& header_path : direct_dependencies(path)) {
+            if (visited.insert(header_path.native()).second) {
+                ret.push_back(header_path);
+                find_dependencies(header_path, ret, visited);
+            }
+        }
+    }
+
+    const std::vector<std::filesystem::path>& direct_dependencies(const std::filesystem::path& path) {
+        Node* node;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto& node_ptr = nodes[path.string()];
+            if (!node_ptr) {
+                node_ptr = std::make_unique<Node>();
+            }
+            node = node_ptr.get();
+        }
+
+        std::call_once(node->scanned, [this, &path, node]() {
+            for (const auto& include : cache.includes(path)) {
+                if (!include.is_angled) {
+                    // First, check locally
+                    auto header_path = path.parent_path() / std::filesystem::path(include.name);
+                    if (is_regular_file(header_path)) {
+                        node->dependencies.push_back(std::move(header_path));
+                        continue;
+                    }
+                }
+
+                // Then, check the include path
+                for (const auto& include_path : include_paths) {
+                    auto header_path = include_path / std::filesystem::path(include.name);
+                    if (is_regular_file(header_path)) {
+                        node->dependencies.push_back(std::move(header_path));
+                    }
+                }
+            }
+        });
+        return node->dependencies;
+    }
+
+    bool is_regular_file(const std::filesystem::path& path) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (auto regular_file_it = regular_files.find(path.string()); regular_file_it != regular_files.end()) {
+                return regular_file_it->second;
+            }
+        }
+
+        bool ret = std::filesystem::is_regular_file(path);
+        std::lock_guard<std::mutex> lock(mutex);
+        regular_files[path.string()] = ret;
+        return ret;
+    }
+};
+
+struct SourceFile {
+    std::filesystem::path path;
+    std::filesystem::path object_path;
+    SourceFileType type;
+    DependencyList dependency_list; // Null if dependencies weren't scanned
+    std::vector<std::filesystem::path> unity_members; // The sources a generated unity source includes, if this is one
+    bool uses_precompiled_header = false;
+
+    const std::vector<std::filesystem::path>& dependencies() const {
+        static const std::vector<std::filesystem::path> no_dependencies;
+        return dependency_list ? *dependency_list : no_dependencies;
+    }
+};
+
+// Splits the sources into batches of up to batch_size sources that get compiled together through generated unity sources
+// Batches never mix languages or directories, and sources with similar dependencies are put in the same batch when possible
+void group_unity_sources(std::vector<SourceFile>& source_files, const std::string& artifact_path, unsigned int batch_size, const std::vector<std::string>& exclude_patterns, std::unordered_map<std::string, unsigned int>& object_indices) {
+    std::vector<SourceFile> ret;
+    std::map<std::pair<SourceFileType, std::string>, std::vector<SourceFile>> groups;
+    for (auto& source_file : source_files) {
+        std::string normal_path = source_file.path.lexically_normal().generic_string();
+        if (std::any_of(exclude_patterns.begin(), exclude_patterns.end(), [&normal_path](const auto& pattern) {
+                return glob_match(pattern, normal_path);
+            })) {
+            ret.push_back(std::move(source_file));
+        } else {
+            groups[{source_file.type, source_file.path.parent_path().generic_string()}].push_back(std::move(source_file));
+        }
+    }
+
+    unsigned int unity_index = 0;
+    for (auto& [group_key, group] : groups) {
+        // Sorting by the sorted dependency lists brings together sources that include the same headers
+        std::vector<std::pair<std::vector<std::string>, SourceFile*>> sorted_group;
+        for (auto& source_file : group) {
+            std::vector<std::string> dependencies;
+            for (const auto& dependency : source_file.dependencies()) {
+                dependencies.push_back(dependency.lexically_normal().generic_string());
+            }
+            std::sort(dependencies.begin(), dependencies.end());
+            sorted_group.emplace_back(std::move(dependencies), &source_file);
+        }
+        std::stable_sort(sorted_group.begin(), sorted_group.end(), [](const auto& a, const auto& b) {
+            return a.first < b.first;
+        });
+
+        for (size_t i = 0; i < sorted_group.size(); i += batch_size) {
+            size_t end = std::min<size_t>(i + batch_size, sorted_group.size());
+            if (end - i == 1) {
+                ret.push_back(std::move(*sorted_group[i].second));
+                continue;
+            }
+
+            std::string stem = "unity_" + std::to_string(unity_index++);
+            SourceFile unity_source_file;
+            unity_source_file.path = std::filesystem::path(artifact_path) / (stem + (group_key.first == SOURCE_FILE_C ? ".c" : ".cpp"));
+            unity_source_file.object_path = std::filesystem::path(artifact_path) / (stem + '_' + std::to_string(object_indices[stem]++));
+            unity_source_file.type = group_key.first;
+            std::vector<std::filesystem::path> dependencies;
+            for (size_t j = i; j < end; ++j) {
+                const auto& member = *sorted_group[j].second;
+                unity_source_file.unity_members.push_back(member.path);
+                dependencies.push_back(member.path);
+                dependencies.insert(dependencies.end(), member.dependencies().begin(), member.dependencies().end());
+            }
+            std::sort(dependencies.begin(), dependencies.end());
+            dependencies.erase(std::unique(dependencies.begin(), dependencies.end()), dependencies.end());
+            unity_source_file.dependency_list = std::make_shared<const std::vector<std::filesystem::path>>(std::move(dependencies));
+            ret.push_back(std::move(unity_source_file));
+        }
+    }
+    source_files = std::move(ret);
+}
+
+// Picks the headers worth precompiling, which are the most widely included headers that at least threshold of the C++ sources include all of
+// The chosen headers are returned in the order they are first included, and the sources that include all of them are marked as users of the precompiled header
+std::vector<std::filesystem::path> choose_precompiled_headers(std::vector<SourceFile>& source_files, double threshold) {
+    std::vector<SourceFile*> cpp_source_files;
+    std::unordered_map<std::string, std::vector<size_t>> includers; // Maps each header to the indices of the C++ sources that include it
+    for (auto& source_file : source_files) {
+        if (source_file.type == SOURCE_FILE_CPP) {
+            std::unordered_set<std::string> dependencies;
+            for (const auto& dependency : source_file.dependencies()) {
+                if (std::string normal_path = dependency.lexically_normal().generic_string(); dependencies.insert(normal_path).second) {
+                    includers[normal_path].push_back(cpp_source_files.size());
+                }
+            }
+            cpp_source_files.push_back(&source_file);
+        }
+    }
+
+    std::vector<std::pair<std::string, const std::vector<size_t>*>> candidates;
+    for (const auto& includer : includers) {
+        candidates.emplace_back(includer.first, &includer.second);
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) {
+        return a.second->size() != b.second->size() ? a.second->size() > b.second->size() : a.first < b.first;
+    });
+
+    // Headers are added greedily for as long as enough sources still include every header chosen so far
+    size_t required_count = std::max<size_t>(2, std::ceil(threshold * cpp_source_files.size()));
+    std::vector<bool> is_user(cpp_source_files.size(), true);
+    std::unordered_set<std::string> chosen_headers;
+    for (const auto& [header, header_includers] : candidates) {
+        if (header_includers->size() < required_count) {
+            break;
+        }
+
+        std::vector<bool> new_is_user(cpp_source_files.size(), false);
+        size_t user_count = 0;
+        for (size_t index : *header_includers) {
+            if (is_user[index]) {
+                new_is_user[index] = true;
+                ++user_count;
+            }
+        }
+        if (user_count >= required_count) {
+            is_user = std::move(new_is_user);
+            chosen_headers.insert(header);
+        }
+    }
+
+    std::vector<std::filesystem::path> ret;
+    if (chosen_headers.empty()) {
+        return ret;
+    }
+    for (size_t i = 0; i < cpp_source_files.size(); ++i) {
+        if (is_user[i]) {
+            if (ret.empty()) {
+                for (const auto& dependency : cpp_source_files[i]->dependencies()) {
+                    if (chosen_headers.erase(dependency.lexically_normal().generic_string())) {
+                        ret.push_back(dependency.lexically_normal());
+                    }
                 }
             }
+            cpp_source_files[i]->uses_precompiled_header = true;
+        }
+    }
+    return ret;
+}
+
+// Returns the lines of a generated unity source, which include each of its members relative to the unity source itself
+std::vector<std::string> unity_source_lines(const SourceFile& source_file) {
+    std::filesystem::path directory = std::filesystem::absolute(source_file.path).parent_path().lexically_normal();
+    std::vector<std::string> ret;
+    for (const auto& member : source_file.unity_members) {
+        std::filesystem::path member_path = std::filesystem::absolute(member).lexically_normal();
+        std::filesystem::path relative_path = member_path.lexically_relative(directory);
+        ret.push_back("#include \"" + (relative_path.empty() ? member_path : relative_path).generic_string() + '"');
+    }
+    return ret;
+}
+
+// Produces a shell command that writes a generated unity source
+std::string unity_source_command(const SourceFile& source_file) {
+    std::string ret = "printf '%s\\n'";
+    for (const auto& line : unity_source_lines(source_file)) {
+        ret += " '";
+        for (char c : line) {
+            if (c == '\'') {
+                ret += "'\\''";
+            } else {
+                ret.push_back(c);
+            }
+        }
+        ret.push_back('\'');
+    }
+    return ret + " > " + source_file.path.generic_string();
+}
+
+// The [paths] table of Polybuild.toml
+struct PathsConfig {
+    std::string output_path;
+    std::vector<std::string> source_paths;
+    std::vector<std::string> include_paths;
+    std::vector<std::string> library_paths;
+    std::string artifact_path;
+    std::string install_path;
+    bool is_recursive = false;
+    std::vector<std::string> ignore_patterns;
+};
+
+// The [options] table of Polybuild.toml
+struct OptionsConfig {
+    std::string c_compiler = "$(CC)";
+    std::string cpp_compiler = "$(CXX)";
+    std::string c_compilation_flags = "$(CFLAGS)";
+    std::string cpp_compilation_flags = "$(CXXFLAGS)";
+    std::string link_time_flags = "$(LDFLAGS)";
+    std::vector<std::string> libraries;
+    std::vector<std::string> static_libraries;
+    std::vector<std::string> pkg_config_libraries;
+    std::vector<std::string> preludes;
+    std::vector<std::string> clean_preludes;
+    bool is_shared = false;
+    bool is_static = false;
+    std::string dependency_mode = "scan";
+    std::string backend = "make";
+    bool has_compilation_database = false;
+    bool has_compilation_cache = false;
+    bool is_unity = false;
+    unsigned int unity_batch_size = 8;
+    std::vector<std::string> unity_exclude_patterns;
+    std::string pch = "none";
+    double pch_threshold = 0.5;
+    unsigned int scan_jobs = std::thread::hardware_concurrency();
+};
+
+// An [env.VARIABLE.value] table, whose settings are used when the environment variable has the value
+// Anything it leaves unset falls back to [paths] and [options], so they're optional rather than copies of the defaults
+struct EnvConfig {
+    struct Paths {
+        std::optional<std::vector<std::string>> library_paths;
+        std::optional<std::string> install_path;
+    } paths;
+
+    struct Options {
+        std::optional<std::string> c_compiler;
+        std::optional<std::string> cpp_compiler;
+        std::optional<std::string> c_compilation_flags;
+        std::optional<std::string> cpp_compilation_flags;
+        std::optional<std::string> link_time_flags;
+        std::optional<std::vector<std::string>> libraries;
+        std::optional<std::vector<std::string>> static_libraries;
+        std::optional<std::vector<std::string>> pkg_config_libraries;
+        std::optional<bool> is_static;
+    } options;
+};
+
+struct PolybuildConfig {
+    PathsConfig paths;
+    OptionsConfig options;
+    std::map<std::string, std::map<std::string, EnvConfig>> env; // Sorted, so the generated variable definitions are stable
+};
+
+namespace toml {
+    template <>
+    struct from<PathsConfig> {
+        static PathsConfig from_toml(const value& v) {
+            PathsConfig paths;
+            decode_fields(v, paths,
+                required_field("output", &PathsConfig::output_path),
+                required_field("source", &PathsConfig::source_paths),
+                field("include", &PathsConfig::include_paths),
+                field("library", &PathsConfig::library_paths),
+                required_field("artifact", &PathsConfig::artifact_path),
+                field("install", &PathsConfig::install_path),
+                field("recursive", &PathsConfig::is_recursive),
+                field("ignore", &PathsConfig::ignore_patterns));
+            return paths;
+        }
+    };
+
+    template <>
+    struct from<OptionsConfig> {
+        static OptionsConfig from_toml(const value& v) {
+            OptionsConfig options;
+            decode_fields(v, options,
+                field("c-compiler", &OptionsConfig::c_compiler),
+                field("compiler", &OptionsConfig::cpp_compiler), // Older name of cpp-compiler
+                field("cpp-compiler", &OptionsConfig::cpp_compiler),
+                field("c-compilation-flags", &OptionsConfig::c_compilation_flags),
+                field("compilation-flags", &OptionsConfig::cpp_compilation_flags), // Older name of cpp-compilation-flags
+                field("cpp-compilation-flags", &OptionsConfig::cpp_compilation_flags),
+                field("link-time-flags", &OptionsConfig::link_time_flags),
+                field("libraries", &OptionsConfig::libraries),
+                field("static-libraries", &OptionsConfig::static_libraries),
+                field("pkg-config-libraries", &OptionsConfig::pkg_config_libraries),
+                field("preludes", &OptionsConfig::preludes),
+                field("clean-preludes", &OptionsConfig::clean_preludes),
+                field("shared", &OptionsConfig::is_shared),
+                field("static", &OptionsConfig::is_static),
+                field("dependency-mode", &OptionsConfig::dependency_mode),
+                field("backend", &OptionsConfig::backend),
+                field("compilation-database", &OptionsConfig::has_compilation_database),
+                field("compilation-cache", &OptionsConfig::has_compilation_cache),
+                field("unity", &OptionsConfig::is_unity),
+                field("unity-batch-size", &OptionsConfig::unity_batch_size),
+                field("unity-exclude", &OptionsConfig::unity_exclude_patterns),
+                field("pch", &OptionsConfig::pch),
+                field("pch-threshold", &OptionsConfig::pch_threshold),
+                field("scan-jobs", &OptionsConfig::scan_jobs));
+            return options;
+        }
+    };
+
+    template <>
+    struct from<EnvConfig::Paths> {
+        static EnvConfig::Paths from_toml(const value& v) {
+            EnvConfig::Paths paths;
+            decode_fields(v, paths,
+                field("library", &EnvConfig::Paths::library_paths),
+                field("install", &EnvConfig::Paths::install_path));
+            return paths;
+        }
+    };
+
+    template <>
+    struct from<EnvConfig::Options> {
+        static EnvConfig::Options from_toml(const value& v) {
+            EnvConfig::Options options;
+            decode_fields(v, options,
+                field("c-compiler", &EnvConfig::Options::c_compiler),
+                field("compiler", &EnvConfig::Options::cpp_compiler),
+                field("cpp-compiler", &EnvConfig::Options::cpp_compiler),
+                field("c-compilation-flags", &EnvConfig::Options::c_compilation_flags),
+                field("compilation-flags", &EnvConfig::Options::cpp_compilation_flags),
+                field("cpp-compilation-flags", &EnvConfig::Options::cpp_compilation_flags),
+                field("link-time-flags", &EnvConfig::Options::link_time_flags),
+                field("libraries", &EnvConfig::Options::libraries),
+                field("static-libraries", &EnvConfig::Options::static_libraries),
+                field("pkg-config-libraries", &EnvConfig::Options::pkg_config_libraries),
+                field("static", &EnvConfig::Options::is_static));
+            return options;
+        }
+    };
+
+    template <>
+    struct from<EnvConfig> {
+        static EnvConfig from_toml(const value& v) {
+            EnvConfig env;
+            decode_fields(v, env,
+                field("paths", &EnvConfig::paths),
+                field("options", &EnvConfig::options));
+            return env;
+        }
+    };
+} // namespace toml
+
+// Everything the backends need to know about the project
+struct Project {
+    std::string output_path;
+    std::string artifact_path;
+    std::vector<std::string> preludes;
+    std::vector<std::string> clean_preludes;
+    std::string dependency_mode;
+    std::string variable_definitions; // The make variables at the top of .polybuild.mk, which every backend evaluates
+    std::vector<SourceFile> source_files;
+    std::optional<SourceFile> precompiled_header; // Generated like a unity source, with the chosen headers as its members
+
+    bool has_cpp() const {
+        return std::any_of(source_files.begin(), source_files.end(), [](const auto& source_file) {
+            return source_file.type == SOURCE_FILE_CPP;
+        });
+    }
+};
+
+std::string echo(const std::string& str) {
+    std::ostringstream ss;
+    ss << "@printf \"\\033[1m[POLYBUILD]\\033[0m %s\\n\"" << ' ' << std::quoted(str);
+    return ss.str();
+}
+
+std::string log(const std::string& str) {
+    return "\033[1m[POLYBUILD]\033[0m " + str;
+}
+
+std::ostream& generate_compilation_flags(std::ostream& os, const std::string& variable, const std::string& flags, const std::vector<std::string>& include_paths, bool is_shared, bool is_static, const std::vector<std::string>& pkg_config_libraries) {
+    os << variable << " := " << flags << " $(active_debug_compilation_flag)";
+    for (const auto& include_path : include_paths) {
+        os << " $(include_path_flag)" << include_path;
+    }
+    if (is_shared) {
+        os << " $(shared_flag)";
+    }
+    if (is_static) {
+        os << " $(active_static_flag)";
+    } else {
+        os << " $(active_dynamic_flag)";
+    }
+    if (!pkg_config_libraries.empty()) {
+        os << " `pkg-config $(pkg_config_syntax) --cflags";
+        for (const auto& pkg_config_library : pkg_config_libraries) {
+            os << ' ' << pkg_config_library;
+        }
+        os << '`';
+    }
+    os << '\n';
+    return os;
+}
+
+// Evaluates the variable definitions that Polybuild generates, giving the values make would see in the current environment
+// Only the subset of make syntax Polybuild emits is supported: := assignments, ifeq/else/endif, and variable and substitution references
+class MakeVariables {
+public:
+    MakeVariables() = default;
+    MakeVariables(const MakeVariables& other):
+        variables(other.variables) {}
+    explicit MakeVariables(std::string_view definitions) {
+        std::vector<bool> conditions; // Whether the current branch of each enclosing conditional is taken
+        auto is_active = [&conditions]() {
+            return std::find(conditions.begin(), conditions.end(), false) == conditions.end();
+        };
+
+        for (size_t line_begin = 0; line_begin < definitions.size();) {
+            size_t line_end = std::min(definitions.find('\n', line_begin), definitions.size());
+            std::string_view line = trim(definitions.substr(line_begin, line_end - line_begin));
+            line_begin = line_end + 1;
+
+            if (line.empty() || line.front() == '#') {
+                continue;
+            } else if (line.substr(0, 5) == "ifeq ") {
+                bool condition = false;
+                if (std::string_view arguments = trim(line.substr(5)); is_active() && arguments.size() >= 2 && arguments.front() == '(' && arguments.back() == ')') {
+                    arguments = arguments.substr(1, arguments.size() - 2);
+                    size_t comma = find_unnested(arguments, ',');
+                    if (comma != std::string_view::npos) {
+                        condition = trim(expand(arguments.substr(0, comma))) == trim(expand(arguments.substr(comma + 1)));
+                    }
+                }
+                conditions.push_back(condition);
+            } else if (line == "else") {
+                if (!conditions.empty()) {
+                    conditions.back() = !conditions.back();
+                }
+            } else if (line == "endif") {
+                if (!conditions.empty()) {
+                    conditions.pop_back();
+                }
+            } else if (size_t op = line.find(":="); is_active() && op != std::string_view::npos) {
+                set(std::string(trim(line.substr(0, op))), expand(trim(line.substr(op + 2))));
+            }
+        }
+    }
+
+    void set(std::string name, std::string value) {
+        variables[std::move(name)] = std::move(value);
+    }
+
+    std::string get(const std::string& name) const {
+        if (auto variable_it = variables.find(name); variable_it != variables.end()) {
+            return variable_it->second;
+        }
+
+        // The makefile wrapper forces MSVC on Windows
+        if ((name == "CC" || name == "CXX") && get("OS") == "Windows_NT") {
+            return "cl";
+        } else if (const char* value = getenv(name.c_str())) {
+            return value;
+        }
+
+        // Defaults provided by the makefile wrapper or make itself
+        if (name == "MODE") {
+            return "release";
+        } else if (name == "OS") {
+#ifdef _WIN32
+            return "Windows_NT";
+#else
+            struct utsname system_info;
+            return uname(&system_info) == 0 ? system_info.sysname : "";
+#endif
+        } else if (name == "CC") {
+            return "cc";
+        } else if (name == "CXX") {
+            return "g++";
+        }
+        return {};
+    }
+
+    // Expands variable references in text, with target and prerequisite standing in for $@ and $<
+    std::string expand(std::string_view text, std::string_view target = {}, std::string_view prerequisite = {}) const {
+        auto lookup = [this, target, prerequisite](const std::string& name) {
+            if (name == "@") {
+                return std::string(target);
+            } else if (name == "<") {
+                return std::string(prerequisite);
+            }
+            return get(name);
+        };
+
+        std::string ret;
+        for (size_t i = 0; i < text.size(); ++i) {
+            if (text[i] != '$' || i + 1 == text.size()) {
+                ret.push_back(text[i]);
+            } else if (char c = text[++i]; c == '(' || c == '{') {
+                size_t reference_end = find_unnested(text.substr(i + 1), c == '(' ? ')' : '}');
+                std::string reference = expand(text.substr(i + 1, reference_end), target, prerequisite);
+                i = reference_end == std::string_view::npos ? text.size() : i + 1 + reference_end;
+
+                // Substitution references, like $(objects:.o=.d), replace a suffix of each word
+                size_t colon = reference.find(':');
+                size_t equals = colon == std::string::npos ? std::string::npos : reference.find('=', colon);
+                if (equals != std::string::npos) {
+                    std::istringstream words(lookup(reference.substr(0, colon)));
+                    std::string_view from = std::string_view(reference).substr(colon + 1, equals - colon - 1);
+                    std::string_view to = std::string_view(reference).substr(equals + 1);
+                    bool first = true;
+                    for (std::string word; words >> word; first = false) {
+                        if (!first) ret.push_back(' ');
+                        if (word.size() >= from.size() && std::string_view(word).substr(word.size() - from.size()) == from) {
+                            word.replace(word.size() - from.size(), from.size(), to);
+                        }
+                        ret += word;
+                    }
+                } else {
+                    ret += lookup(reference);
+                }
+            } else if (c == '$') {
+                ret.push_back('$');
+            } else {
+                ret += lookup(std::string(1, c));
+            }
+        }
+        return ret;
+    }
+
+    // Expands a recipe and splits it into the arguments of the command it runs
+    // `command` substitutions, which Polybuild uses for pkg-config, are run once and their results are reused
+    std::vector<std::string> expand_command(std::string_view recipe, std::string_view target = {}, std::string_view prerequisite = {}) const {
+        std::string command = expand(recipe, target, prerequisite);
+        for (size_t begin; (begin = command.find('`')) != std::string::npos;) {
+            size_t end = command.find('`', begin + 1);
+            if (end == std::string::npos) {
+                break;
+            }
+
+            std::string substitution = command.substr(begin + 1, end - begin - 1);
+            std::unique_lock<std::mutex> lock(substitutions_mutex);
+            auto substitution_it = substitutions.find(substitution);
+            if (substitution_it == substitutions.end()) {
+                lock.unlock();
+                std::string output = capture_output(substitution);
+                lock.lock();
+                substitution_it = substitutions.emplace(substitution, std::move(output)).first;
+            }
+            command.replace(begin, end - begin + 1, substitution_it->second);
+        }
+        return split_shell_words(command);
+    }
+
+private:
+    std::unordered_map<std::string, std::string> variables;
+    mutable std::mutex substitutions_mutex;
+    mutable std::unordered_map<std::string, std::string> substitutions;
+
+    // Finds the first occurrence of c that isn't inside parentheses or braces
+    static size_t find_unnested(std::string_view str, char c) {
+        size_t depth = 0;
+        for (size_t i = 0; i < str.size(); ++i) {
+            if (depth == 0 && str[i] == c) {
+                return i;
+            } else if (str[i] == '(' || str[i] == '{') {
+                ++depth;
+            } else if ((str[i] == ')' || str[i] == '}') && depth) {
+                --depth;
+            }
+        }
+        return std::string_view::npos;
+    }
+};
+
+// Returns the recipe that compiles $< into $@, optionally having the compiler write a depfile for make to include
+std::string compilation_recipe(SourceFileType type, bool write_depfile, bool use_precompiled_header = false) {
+    std::string ret;
+    if (type == SOURCE_FILE_CPP) {
+        ret = "$(cpp_compiler) $(compile_only_flag) $< $(cpp_compilation_flags)";
+    } else {
+        ret = "$(c_compiler) $(compile_only_flag) $< $(c_compilation_flags)";
+    }
+    if (use_precompiled_header) {
+        ret += " $(pch_flags)";
+    }
+    if (write_depfile) {
+        ret += " $(depfile_flags) $(@:$(obj_ext)=$(depfile_ext))";
+    }
+    return ret + " $(obj_path_flag)$@";
+}
+
+// Returns the recipe that links $(objects) into $@
+// The precompiled header is compiled with the same flags as the sources that use it, since compilers refuse to use it otherwise
+std::string precompiled_header_recipe() {
+    return "$(cpp_compiler) $(pch_create_flags) $< $(cpp_compilation_flags) $(obj_path_flag)$@";
+}
+
+std::string link_recipe(const Project& project) {
+    if (project.has_cpp()) {
+        return "$(cpp_compiler) $(objects) $(static_libraries) $(cpp_compilation_flags) $(out_path_flag)$@ $(link_flag) $(link_time_flags) $(libraries)";
+    } else {
+        return "$(c_compiler) $(objects) $(static_libraries) $(c_compilation_flags) $(out_path_flag)$@ $(link_flag) $(link_time_flags) $(libraries)";
+    }
+}
+
+// The makefile is written straight to a stream, since it lists the headers of every source and can be hundreds of megabytes large
+void generate_makefile(std::ostream& makefile, const Project& project) {
+    makefile << "# This file was auto-generated by Polybuild\n\n";
+    makefile << project.variable_definitions;
+
+    makefile << "\nall: " << project.output_path << "$(out_ext)\n";
+    makefile << ".PHONY: all\n";
+
+    auto generate_unity_source_rule = [&makefile, &project](const SourceFile& source_file) {
+        std::string command;
+        for (char c : unity_source_command(source_file)) {
+            command += c == '$' ? "$$" : std::string(1, c);
+        }
+        makefile << '\n'
+                 << source_file.path.generic_string() << ": .polybuild.mk\n";
+        makefile << '\t' << echo("Generating $@...") << '\n';
+        makefile << "\t@mkdir -p " << project.artifact_path << '\n';
+        makefile << "\t@" << command << '\n';
+        makefile << '\t' << echo("Finished generating $@!") << '\n';
+    };
+
+    // Compilers that can't use the precompiled header leave pch_ext empty, so nothing depends on the precompiled header itself
+    std::string precompiled_header_path;
+    if (project.precompiled_header) {
+        precompiled_header_path = project.precompiled_header->path.generic_string();
+        generate_unity_source_rule(*project.precompiled_header);
+
+        makefile << '\n'
+                 << precompiled_header_path << ".gch: " << precompiled_header_path << " .polybuild.mk";
+        for (const auto& depdendency : project.precompiled_header->dependencies()) {
+            makefile << ' ' << depdendency.generic_string();
+        }
+        makefile << '\n';
+
+        makefile << '\t' << echo("Precompiling $@ from $<...") << '\n';
+        makefile << "\t@mkdir -p " << project.artifact_path << '\n';
+        makefile << "\t@" << precompiled_header_recipe() << '\n';
+        makefile << '\t' << echo("Finished precompiling $@ from $<!") << '\n';
+    }
+
+    for (const auto& source_file : project.source_files) {
+        if (!source_file.unity_members.empty()) {
+            generate_unity_source_rule(source_file);
+        }
+
+        makefile << '\n'
+                 << source_file.object_path.generic_string() << "$(obj_ext): " << source_file.path.generic_string() << " .polybuild.mk";
+        if (source_file.uses_precompiled_header) {
+            makefile << ' ' << precompiled_header_path << "$(pch_ext)";
+        }
+        for (const auto& depdendency : source_file.dependencies()) {
+            makefile << ' ' << depdendency.generic_string();
+        }
+        makefile << '\n';
+
+        makefile << '\t' << echo("Compiling $@ from $<...") << '\n';
+        makefile << "\t@mkdir -p " << project.artifact_path << '\n';
+        makefile << "\t@" << compilation_recipe(source_file.type, project.dependency_mode == "compiler", source_file.uses_precompiled_header) << '\n';
+        makefile << '\t' << echo("Finished compiling $@ from $<!") << '\n';
+    }
+
+    makefile << "\nobjects := ";
+    for (const auto& source_file : project.source_files) {
+        makefile << ' ' << source_file.object_path.generic_string() << "$(obj_ext)";
+    }
+    makefile << '\n';
+    if (project.dependency_mode == "compiler") {
+        // MSVC writes JSON depfiles, which make can't read
+        makefile << "ifneq ($(OS),Windows_NT)\n";
+        makefile << "-include $(objects:$(obj_ext)=$(depfile_ext))\n";
+        makefile << "endif\n";
+    }
+
+    makefile << project.output_path << "$(out_ext): .polybuild.mk $(objects) $(static_libraries)\n";
+    makefile << "\t" << echo("Building $@...") << '\n';
+    {
+        auto path = std::filesystem::path(project.output_path);
+        if (path.has_parent_path()) {
+            makefile << "\t@mkdir -p " << path.parent_path().generic_string() << '\n';
+        }
+    }
+    makefile << "\t@" << link_recipe(project) << "\n\t" << echo("Finished building $@!") << '\n';
+
+    makefile << "\nclean:";
+    for (const auto& clean_prelude : project.clean_preludes) {
+        makefile << "\n\t" << echo("Executing clean prelude: " + clean_prelude);
+        makefile << "\n\t@" << clean_prelude;
+    }
+    makefile << "\n\t" << echo("Deleting " + project.output_path + "$(out_ext) and " + project.artifact_path + "...") << '\n';
+    makefile << "\t@rm -rf " << project.output_path << "$(out_ext) " << project.artifact_path << '\n';
+    makefile << '\t' << echo("Finished deleting " + project.output_path + "$(out_ext) and " + project.artifact_path + '!') << '\n';
+    makefile << ".PHONY: clean\n";
+
+    makefile << "\ninstall:\n";
+    makefile << '\t' << echo("Copying " + project.output_path + "$(out_ext) to $(prefix)...") << '\n';
+    makefile << "\t@cp " << project.output_path << "$(out_ext) $(prefix)\n";
+    makefile << '\t' << echo("Finished copying " + project.output_path + "$(out_ext) to $(prefix)!") << '\n';
+    makefile << ".PHONY: install\n";
+}
+
+std::string generate_wrapper(const Project& project) {
+    std::ostringstream wrapper;
+    wrapper << "# This file was auto-generated by Polybuild\n\n";
+
+    wrapper << "ifndef MODE\n";
+    wrapper << "\tMODE := release\n";
+    wrapper << "\texport MODE\n";
+    wrapper << "endif\n\n";
+
+    wrapper << "ifndef OS\n";
+    wrapper << "\tOS := $(shell uname)\n";
+    wrapper << "\texport OS\n";
+    wrapper << "endif\n\n";
+
+    wrapper << "ifeq ($(OS),Windows_NT)\n";
+    wrapper << "\tCC := cl\n";
+    wrapper << "\tCXX := cl\n";
+    wrapper << "\tCL := /nologo\n";
+    wrapper << "\tLINK := /nologo\n";
+    wrapper << "\tMSYS_NO_PATHCONV := 1\n";
+    wrapper << "\texport CC CXX CL MSYS_NO_PATHCONV\n";
+    wrapper << "endif\n";
+
+    wrapper << "\nall:";
+    for (unsigned int i = 0; i < project.preludes.size(); ++i) {
+        wrapper << " prelude" << i;
+    }
+    wrapper << "\n\t@\"$(MAKE)\" -f .polybuild.mk --no-print-directory\n";
+    wrapper << ".PHONY: all\n";
+
+    for (unsigned int i = 0; i < project.preludes.size(); ++i) {
+        wrapper << "\nprelude" << i << ":\n";
+        wrapper << '\t' << echo("Executing prelude: " + project.preludes[i]) << '\n';
+        wrapper << "\t@" << project.preludes[i] << '\n';
+        wrapper << ".PHONY: prelude" << i << '\n';
+    }
+
+    wrapper << "\nclean:\n";
+    wrapper << "\t@\"$(MAKE)\" -f .polybuild.mk --no-print-directory $@\n";
+    wrapper << ".PHONY: clean\n";
+
+    wrapper << "\ninstall:\n";
+    wrapper << "\t@\"$(MAKE)\" -f .polybuild.mk --no-print-directory $@\n";
+    wrapper << ".PHONY: install\n";
+    return wrapper.str();
+}
+
+// Produces a compile_commands.json describing how each source is compiled in the current environment
+std::string generate_compilation_database(const Project& project, const MakeVariables& variables) {
+    std::string directory = std::filesystem::current_path().generic_string();
+    std::string obj_ext = variables.get("obj_ext");
+
+    std::ostringstream database;
+    database << '[';
+    bool is_first = true;
+    for (const auto& source_file : project.source_files) {
+        // Members of unity sources are listed with the flags of their unity sources, since that's how they really get compiled
+        std::string object_path = source_file.object_path.generic_string() + obj_ext;
+        std::vector<std::filesystem::path> source_paths = source_file.unity_members;
+        if (source_paths.empty()) {
+            source_paths.push_back(source_file.path);
+        }
+        for (const auto& path : source_paths) {
+            std::string source_path = path.generic_string();
+            database << (is_first ? "\n" : ",\n");
+            database << "  {\n";
+            database << "    \"directory\": " << json_escape(directory) << ",\n";
+            database << "    \"arguments\": [";
+            auto arguments = variables.expand_command(compilation_recipe(source_file.type, false), object_path, source_path);
+            for (auto argument_it = arguments.begin(); argument_it != arguments.end(); ++argument_it) {
+                database << (argument_it == arguments.begin() ? "" : ", ") << json_escape(*argument_it);
+            }
+            database << "],\n";
+            database << "    \"file\": " << json_escape(source_path) << ",\n";
+            database << "    \"output\": " << json_escape(object_path) << '\n';
+            database << "  }";
+            is_first = false;
+        }
+    }
+    database << "\n]\n";
+    return database.str();
+}
+
+std::string ninja_escape(std::string_view str, bool is_path = false) {
+    std::string ret;
+    for (char c : str) {
+        if (c == '$' || c == '\n' || (is_path && (c == ' ' || c == ':'))) {
+            ret.push_back('$');
+        }
+        ret.push_back(c);
+    }
+    return ret;
+}
+
+// Ninja has no conditionals, so everything is resolved for the current environment up front
+// Header dependencies always come from the compiler, which ninja reads back with deps = gcc or deps = msvc
+std::string generate_ninja(const Project& project, MakeVariables variables) {
+    bool is_msvc = variables.get("OS") == "Windows_NT";
+    std::string obj_ext = variables.get("obj_ext");
+    std::string output_path = project.output_path + variables.get("out_ext");
+
+    std::string objects;
+    for (const auto& source_file : project.source_files) {
+        if (!objects.empty()) objects.push_back(' ');
+        objects += source_file.object_path.generic_string() + obj_ext;
+    }
+    variables.set("objects", objects);
+
+    std::string prelude_targets;
+    for (unsigned int i = 0; i < project.preludes.size(); ++i) {
+        prelude_targets += " prelude" + std::to_string(i);
+    }
+
+    std::ostringstream ninja;
+    ninja << "# This file was auto-generated by Polybuild\n\n";
+    ninja << "ninja_required_version = 1.3\n";
+
+    ninja << "\nrule compile\n";
+    ninja << "  command = $command\n";
+    ninja << "  description = Compiling $out from $in...\n";
+    if (is_msvc) {
+        ninja << "  deps = msvc\n";
+    } else {
+        ninja << "  depfile = $out.d\n";
+        ninja << "  deps = gcc\n";
+    }
+    ninja << "  restat = 1\n";
+
+    ninja << "\nrule link\n";
+    ninja << "  command = $command\n";
+    ninja << "  description = Building $out...\n";
+    ninja << "  restat = 1\n";
+
+    ninja << "\nrule run\n";
+    ninja << "  command = $command\n";
+    ninja << "  description = $description\n";
+
+    for (unsigned int i = 0; i < project.preludes.size(); ++i) {
+        ninja << "\nbuild prelude" << i << ": run\n";
+        ninja << "  command = " << ninja_escape(project.preludes[i]) << '\n';
+        ninja << "  description = " << ninja_escape("Executing prelude: " + project.preludes[i]) << '\n';
+    }
+
+    auto generate_unity_source_edge = [&ninja, &project](const SourceFile& source_file) {
+        std::string source_path = source_file.path.generic_string();
+        ninja << "\nbuild " << ninja_escape(source_path, true) << ": run\n";
+        ninja << "  command = " << ninja_escape("mkdir -p " + project.artifact_path + " && " + unity_source_command(source_file)) << '\n';
+        ninja << "  description = " << ninja_escape("Generating " + source_path + "...") << '\n';
+    };
+
+    // Compilers that can't use the precompiled header leave pch_ext empty
+    std::string precompiled_header_path;
+    if (project.precompiled_header && !variables.get("pch_ext").empty()) {
+        std::string source_path = project.precompiled_header->path.generic_string();
+        precompiled_header_path = source_path + variables.get("pch_ext");
+        generate_unity_source_edge(*project.precompiled_header);
+
+        ninja << "\nbuild " << ninja_escape(precompiled_header_path, true) << ": compile " << ninja_escape(source_path, true);
+        if (!prelude_targets.empty()) {
+            ninja << " ||" << prelude_targets;
+        }
+        ninja << "\n  command = " << ninja_escape(variables.expand(precompiled_header_recipe(), precompiled_header_path, source_path) + " -MMD -MF " + precompiled_header_path + ".d") << '\n';
+    }
+
+    for (const auto& source_file : project.source_files) {
+        std::string source_path = source_file.path.generic_string();
+        std::string object_path = source_file.object_path.generic_string() + obj_ext;
+
+        if (!source_file.unity_members.empty()) {
+            generate_unity_source_edge(source_file);
+        }
+
+        std::string command = variables.expand(compilation_recipe(source_file.type, false, source_file.uses_precompiled_header), object_path, source_path);
+        if (is_msvc) {
+            command += " /showIncludes";
+        } else {
+            command += " -MMD -MF " + object_path + ".d";
+        }
+
+        ninja << "\nbuild " << ninja_escape(object_path, true) << ": compile " << ninja_escape(source_path, true);
+        if (source_file.uses_precompiled_header && !precompiled_header_path.empty()) {
+            ninja << " | " << ninja_escape(precompiled_header_path, true);
+        }
+        if (!prelude_targets.empty()) {
+            ninja << " ||" << prelude_targets;
+        }
+        ninja << "\n  command = " << ninja_escape(command) << '\n';
+    }
+
+    ninja << "\nbuild " << ninja_escape(output_path, true) << ": link";
+    for (const auto& source_file : project.source_files) {
+        ninja << ' ' << ninja_escape(source_file.object_path.generic_string() + obj_ext, true);
+    }
+    if (std::istringstream static_libraries(variables.get("static_libraries")); static_libraries.peek() != EOF) {
+        ninja << " |";
+        for (std::string static_library; static_libraries >> static_library;) {
+            ninja << ' ' << ninja_escape(static_library, true);
+        }
+    }
+    if (!prelude_targets.empty()) {
+        ninja << " ||" << prelude_targets;
+    }
+    ninja << "\n  command = " << ninja_escape(variables.expand(link_recipe(project), output_path)) << '\n';
+    ninja << "\ndefault " << ninja_escape(output_path, true) << '\n';
+
+    std::string clean_command;
+    for (const auto& clean_prelude : project.clean_preludes) {
+        clean_command += clean_prelude + " && ";
+    }
+    clean_command += "rm -rf " + output_path + ' ' + project.artifact_path;
+    ninja << "\nbuild clean: run\n";
+    ninja << "  command = " << ninja_escape(clean_command) << '\n';
+    ninja << "  description = " << ninja_escape("Deleting " + output_path + " and " + project.artifact_path + "...") << '\n';
+
+    std::string prefix = variables.get("prefix");
+    ninja << "\nbuild install: run " << ninja_escape(output_path, true) << '\n';
+    ninja << "  command = " << ninja_escape("cp " + output_path + ' ' + prefix) << '\n';
+    ninja << "  description = " << ninja_escape("Copying " + output_path + " to " + prefix + "...") << '\n';
+    return ninja.str();
+}
+
+uint64_t hash_command(const std::vector<std::string>& arguments) {
+    uint64_t ret = hash_bytes({});
+    for (const auto& argument : arguments) {
+        ret = hash_bytes(std::string_view(argument.c_str(), argument.size() + 1), ret);
+    }
+    return ret;
+}
+
+// Remembers the command that produced each output of polybuild build, so outputs get rebuilt when their commands change
+// How long each output took to build is recorded too, so the slowest objects can be started first next time
+class BuildLog {
+public:
+    explicit BuildLog(std::filesystem::path path):
+        path(std::move(path)) {
+        std::ifstream file(this->path, std::ios::binary);
+        std::string line;
+        if (!std::getline(file, line) || line != version_line) {
+            return;
+        }
+
+        while (std::getline(file, line)) {
+            std::istringstream ss(line);
+            Entry entry;
+            std::string output_path;
+            long long duration;
+            if (ss >> entry.command_hash >> duration && ss.get() == ' ' && std::getline(ss, output_path)) {
+                entry.duration = std::chrono::milliseconds(duration);
+                entries[output_path] = entry;
+            }
+        }
+    }
 
-            // Then, check the include path
-            for (std::filesystem::path include_path : include_paths) {
-                auto header_path = include_path / std::filesystem::path(std::string(matches[1]));
-                if (std::filesystem::is_regular_file(header_path)) {
-                    if (std::find(ret.begin(), ret.end(), header_path) == ret.end()) {
-                        ret.push_back(header_path);
-                        find_dependencies(header_path, include_paths, ret);
-                    }
+    bool is_command_unchanged(const std::string& output_path, uint64_t command_hash) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto entry_it = entries.find(output_path);
+        return entry_it != entries.end() && entry_it->second.command_hash == command_hash;
+    }
+
+    // Returns how long the output took to build last time, if it has been built before
+    std::optional<std::chrono::milliseconds> duration(const std::string& output_path) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (auto entry_it = entries.find(output_path); entry_it != entries.end()) {
+            return entry_it->second.duration;
+        }
+        return std::nullopt;
+    }
+
+    void record(const std::string& output_path, uint64_t command_hash, std::chrono::milliseconds duration) {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries[output_path] = {command_hash, duration};
+        dirty = true;
+    }
+
+    void save() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!dirty) {
+            return;
+        }
+
+        std::ostringstream ss;
+        ss << version_line << '\n';
+        for (const auto& entry : entries) {
+            ss << entry.second.command_hash << ' ' << entry.second.duration.count() << ' ' << entry.first << '\n';
+        }
+        write_file_atomically(path, ss.str());
+        dirty = false;
+    }
+
+private:
+    static constexpr std::string_view version_line = "# Polybuild build log v2";
+
+    struct Entry {
+        uint64_t command_hash = 0;
+        std::chrono::milliseconds duration {};
+    };
+
+    std::filesystem::path path;
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, Entry> entries;
+    bool dirty = false;
+};
+
+// A local store of compiled objects, so objects that have been compiled before are restored instead of being compiled again
+// Entries are keyed by the compiler's identity, the full command, the working directory, and the contents of every input
+class CompilationCache {
+public:
+    explicit CompilationCache(std::filesystem::path path):
+        path(std::move(path)) {}
+
+    // Returns the default location of the cache, or an empty path if there isn't one
+    static std::filesystem::path default_path() {
+        if (const char* path = getenv("POLYBUILD_CACHE_DIR"); path && *path) {
+            return path;
+        }
+#ifdef _WIN32
+        if (const char* local_app_data = getenv("LOCALAPPDATA"); local_app_data && *local_app_data) {
+            return std::filesystem::path(local_app_data) / "polybuild" / "cache";
+        }
+#else
+        if (const char* xdg_cache_home = getenv("XDG_CACHE_HOME"); xdg_cache_home && *xdg_cache_home) {
+            return std::filesystem::path(xdg_cache_home) / "polybuild";
+        } else if (const char* home = getenv("HOME"); home && *home) {
+            return std::filesystem::path(home) / ".cache" / "polybuild";
+        }
+#endif
+        return {};
+    }
+
+    std::string key(const std::vector<std::string>& command, const std::vector<std::filesystem::path>& input_paths) {
+        std::string key_material = compiler_identity(command.front());
+        key_material.push_back('\0');
+        std::error_code ec;
+        key_material += std::filesystem::current_path(ec).string(); // Debug information may contain absolute paths
+        key_material.push_back('\0');
+        for (const auto& argument : command) {
+            key_material += argument;
+            key_material.push_back('\0');
+        }
+        for (const auto& input_path : input_paths) {
+            key_material += input_path.generic_string();
+            key_material.push_back('\0');
+            key_material += std::to_string(file_hash(input_path));
+            key_material.push_back('\0');
+        }
+
+        // Two differently seeded hashes make collisions between entries practically impossible
+        std::ostringstream ss;
+        ss << std::hex << std::setfill('0') << std::setw(16) << hash_bytes(key_material) << std::setw(16) << hash_bytes(key_material, 0x9e3779b97f4a7c15);
+        return ss.str();
+    }
+
+    // Puts the object with the given key at object_path, along with its depfile if there is one
+    bool restore(const std::string& key, const std::filesystem::path& object_path, const std::filesystem::path& depfile_path = {}) {
+        std::filesystem::path entry_path = this->entry_path(key);
+        std::error_code ec;
+        if (!depfile_path.empty() && !std::filesystem::copy_file(entry_path.string() + ".d", depfile_path, std::filesystem::copy_options::overwrite_existing, ec)) {
+            return false;
+        }
+
+        // Objects are copied rather than hard linked, since make and ninja let compilers write through existing objects, which would corrupt the entry
+        if (!copy_file_atomically(entry_path, object_path)) {
+            return false;
+        }
+
+        // The restored object must be newer than its inputs to be considered up to date
+        std::filesystem::last_write_time(object_path, std::filesystem::file_time_type::clock::now(), ec);
+        return true;
+    }
+
+    // Copies a freshly compiled object and its depfile, if there is one, into the cache
+    void store(const std::string& key, const std::filesystem::path& object_path, const std::filesystem::path& depfile_path = {}) {
+        std::filesystem::path entry_path = this->entry_path(key);
+        std::error_code ec;
+        std::filesystem::create_directories(entry_path.parent_path(), ec);
+        if (depfile_path.empty() || copy_file_atomically(depfile_path, entry_path.string() + ".d")) {
+            copy_file_atomically(object_path, entry_path); // The object goes in last, since its presence means the entry is complete
+        }
+    }
+
+private:
+    std::filesystem::path path;
+    std::mutex mutex;
+    std::unordered_map<std::string, std::string> compiler_identities;
+    std::unordered_map<std::string, uint64_t> file_hashes;
+
+    std::filesystem::path entry_path(const std::string& key) const {
+        return path / key.substr(0, 2) / key.substr(2);
+    }
+
+    // Identifies a compiler by the location, size, and modification time of its executable, so upgrading it invalidates the cache
+    std::string compiler_identity(const std::string& program) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto [identity_it, inserted] = compiler_identities.try_emplace(program, program);
+        if (inserted) {
+            std::vector<std::filesystem::path> candidates;
+            if (std::filesystem::path(program).has_parent_path()) {
+                candidates.push_back(program);
+            } else if (const char* path_variable = getenv("PATH")) {
+#ifdef _WIN32
+                char separator = ';';
+#else
+                char separator = ':';
+#endif
+                std::istringstream ss(path_variable);
+                for (std::string directory; std::getline(ss, directory, separator);) {
+                    candidates.push_back(std::filesystem::path(directory.empty() ? "." : directory) / program);
+#ifdef _WIN32
+                    candidates.push_back(std::filesystem::path(directory.empty() ? "." : directory) / (program + ".exe"));
+#endif
                 }
             }
-        } else if (std::regex_match(line, matches, angled_include_regex)) {
-            for (std::filesystem::path include_path : include_paths) {
-                auto header_path = include_path / std::filesystem::path(std::string(matches[1]));
-                if (std::filesystem::is_regular_file(header_path)) {
-                    if (std::find(ret.begin(), ret.end(), header_path) == ret.end()) {
-                        ret.push_back(header_path);
-                        find_dependencies(header_path, include_paths, ret);
-                    }
+
+            for (const auto& candidate : candidates) {
+                std::error_code ec;
+                if (std::filesystem::is_regular_file(candidate, ec)) {
+                    auto canonical_path = std::filesystem::canonical(candidate, ec);
+                    auto size = std::filesystem::file_size(candidate, ec);
+                    auto modification_time = std::filesystem::last_write_time(candidate, ec);
+                    identity_it->second = (canonical_path.empty() ? candidate : canonical_path).string() + ' ' + std::to_string(size) + ' ' + std::to_string(modification_time.time_since_epoch().count());
+                    break;
                 }
             }
         }
+        return identity_it->second;
     }
-}
 
-std::string echo(const std::string& str) {
-    std::ostringstream ss;
-    ss << "@printf \"\\033[1m[POLYBUILD]\\033[0m %s\\n\"" << ' ' << std::quoted(str);
-    return ss.str();
-}
+    // Many objects share the same headers, so each file is only hashed once
+    uint64_t file_hash(const std::filesystem::path& path) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (auto hash_it = file_hashes.find(path.string()); hash_it != file_hashes.end()) {
+                return hash_it->second;
+            }
+        }
 
-std::string log(const std::string& str) {
-    return "\033[1m[POLYBUILD]\033[0m " + str;
-}
+        uint64_t hash = hash_bytes(read_file(path));
+        std::lock_guard<std::mutex> lock(mutex);
+        file_hashes.emplace(path.string(), hash);
+        return hash;
+    }
 
-std::ostream& generate_compilation_flags(std::ostream& os, const std::string& variable, const std::string& flags, const std::vector<std::string>& include_paths, bool is_shared, bool is_static, const std::vector<std::string>& pkg_config_libraries) {
-    os << variable << " := " << flags << " $(active_debug_compilation_flag)";
-    for (const auto& include_path : include_paths) {
-        os << " $(include_path_flag)" << include_path;
+    // Other builds may be storing or restoring the same files at the same time, so each copy goes through a temporary file of its own
+    static bool copy_file_atomically(const std::filesystem::path& from, const std::filesystem::path& to) {
+        std::filesystem::path temp_path = unique_temp_path(to);
+
+        std::error_code ec;
+        if (!std::filesystem::copy_file(from, temp_path, std::filesystem::copy_options::overwrite_existing, ec)) {
+            return false;
+        }
+        std::filesystem::rename(temp_path, to, ec);
+        if (ec) {
+            std::filesystem::remove(temp_path, ec);
+            return false;
+        }
+        return true;
     }
-    if (is_shared) {
-        os << " $(shared_flag)";
+};
+
+// Builds the project without make, running compilers directly with up to jobs of them at once
+// If compilation_cache isn't null, objects are restored from it whenever possible
+int build_project(const Project& project, MakeVariables variables, unsigned int jobs, CompilationCache* compilation_cache = nullptr) {
+    std::string obj_ext = variables.get("obj_ext");
+    std::string output_path = project.output_path + variables.get("out_ext");
+
+    std::string objects;
+    for (const auto& source_file : project.source_files) {
+        if (!objects.empty()) objects.push_back(' ');
+        objects += source_file.object_path.generic_string() + obj_ext;
     }
-    if (is_static) {
-        os << " $(active_static_flag)";
-    } else {
-        os << " $(active_dynamic_flag)";
+    variables.set("objects", objects);
+
+    std::mutex output_mutex;
+    auto print = [&output_mutex](const std::string& message) {
+        std::lock_guard<std::mutex> lock(output_mutex);
+        std::cout << log(message) << std::endl;
+    };
+
+    ThreadPool pool(jobs);
+    std::atomic<bool> failed = false;
+    for (const auto& prelude : project.preludes) {
+        pool.schedule([&print, &failed, &prelude]() {
+            print("Executing prelude: " + prelude);
+            if (run_shell_command(prelude) != 0) {
+                print("Error: Prelude failed: " + prelude);
+                failed = true;
+            }
+        });
     }
-    if (!pkg_config_libraries.empty()) {
-        os << " `pkg-config $(pkg_config_syntax) --cflags";
-        for (const auto& pkg_config_library : pkg_config_libraries) {
-            os << ' ' << pkg_config_library;
+    pool.wait();
+    if (failed) {
+        return 1;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(project.artifact_path, ec);
+    BuildLog build_log(std::filesystem::path(project.artifact_path) / ".polybuild-log");
+
+    // Modification times are looked up at most once, since many objects share the same headers
+    std::unordered_map<std::string, std::optional<std::filesystem::file_time_type>> modification_times;
+    auto get_modification_time = [&modification_times](const std::filesystem::path& path) {
+        auto [modification_time_it, inserted] = modification_times.try_emplace(path.string());
+        if (inserted) {
+            std::error_code ec;
+            auto modification_time = std::filesystem::last_write_time(path, ec);
+            if (!ec) {
+                modification_time_it->second = modification_time;
+            }
+        }
+        return modification_time_it->second;
+    };
+    auto is_up_to_date = [&get_modification_time](const std::filesystem::path& output_path, const std::vector<std::filesystem::path>& input_paths) {
+        auto output_modification_time = get_modification_time(output_path);
+        return output_modification_time && std::all_of(input_paths.begin(), input_paths.end(), [&](const auto& input_path) {
+            auto input_modification_time = get_modification_time(input_path);
+            return input_modification_time && *input_modification_time <= *output_modification_time;
+        });
+    };
+
+    struct CompilationJob {
+        const SourceFile* source_file;
+        std::string source_path;
+        std::string object_path;
+        std::vector<std::string> command;
+        uint64_t command_hash;
+        std::optional<std::chrono::milliseconds> duration;
+    };
+
+    auto write_unity_source = [](const SourceFile& source_file) {
+        std::string unity_source;
+        for (const auto& line : unity_source_lines(source_file)) {
+            unity_source += line + '\n';
+        }
+        write_file_if_changed(source_file.path, unity_source);
+    };
+
+    // The precompiled header is built before anything else, since every source that uses it has to wait for it anyway
+    // Compilers that can't use the precompiled header leave pch_ext empty
+    std::string precompiled_header_path;
+    if (std::string pch_ext = variables.get("pch_ext"); project.precompiled_header && !pch_ext.empty()) {
+        write_unity_source(*project.precompiled_header);
+
+        std::string source_path = project.precompiled_header->path.generic_string();
+        precompiled_header_path = source_path + pch_ext;
+        auto command = variables.expand_command(precompiled_header_recipe(), precompiled_header_path, source_path);
+        uint64_t command_hash = hash_command(command);
+
+        std::vector<std::filesystem::path> input_paths = project.precompiled_header->dependencies();
+        input_paths.push_back(project.precompiled_header->path);
+        if (!build_log.is_command_unchanged(precompiled_header_path, command_hash) || !is_up_to_date(precompiled_header_path, input_paths)) {
+            print("Precompiling " + precompiled_header_path + " from " + source_path + "...");
+            auto start_time = std::chrono::steady_clock::now();
+            if (run_process(command) != 0) {
+                print("Error: Failed to precompile " + precompiled_header_path + " from " + source_path);
+                return 1;
+            }
+            build_log.record(precompiled_header_path, command_hash, std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time));
+            modification_times.erase(std::filesystem::path(precompiled_header_path).string());
+            print("Finished precompiling " + precompiled_header_path + " from " + source_path + '!');
         }
-        os << '`';
     }
-    os << '\n';
-    return os;
+
+    bool write_depfiles = project.dependency_mode == "compiler";
+    std::vector<CompilationJob> compilation_jobs;
+    for (const auto& source_file : project.source_files) {
+        if (!source_file.unity_members.empty()) {
+            write_unity_source(source_file);
+        }
+
+        std::string source_path = source_file.path.generic_string();
+        std::string object_path = source_file.object_path.generic_string() + obj_ext;
+        auto command = variables.expand_command(compilation_recipe(source_file.type, write_depfiles, source_file.uses_precompiled_header), object_path, source_path);
+        uint64_t command_hash = hash_command(command);
+
+        std::vector<std::filesystem::path> input_paths;
+        if (write_depfiles) {
+            input_paths = read_depfile(variables.expand("$(@:$(obj_ext)=$(depfile_ext))", object_path));
+        } else {
+            input_paths = source_file.dependencies();
+        }
+        input_paths.push_back(source_file.path);
+        if (source_file.uses_precompiled_header && !precompiled_header_path.empty()) {
+            input_paths.push_back(precompiled_header_path);
+        }
+        if (!build_log.is_command_unchanged(object_path, command_hash) || !is_up_to_date(object_path, input_paths)) {
+            auto duration = build_log.duration(object_path);
+            compilation_jobs.push_back({&source_file, std::move(source_path), std::move(object_path), std::move(command), command_hash, duration});
+        }
+    }
+
+    // Start the objects that took the longest last time first, so the link doesn't end up waiting on a long tail
+    // Objects that haven't been built before might be slow too, so they go ahead of everything else
+    std::stable_sort(compilation_jobs.begin(), compilation_jobs.end(), [](const auto& a, const auto& b) {
+        if (!a.duration || !b.duration) {
+            return !a.duration && b.duration;
+        }
+        return *a.duration > *b.duration;
+    });
+
+    std::atomic<unsigned int> cache_hits = 0;
+    std::atomic<unsigned int> cache_misses = 0;
+    for (auto& compilation_job : compilation_jobs) {
+        pool.schedule([&variables, &print, &failed, &build_log, compilation_cache, &cache_hits, &cache_misses, &compilation_job, write_depfiles]() {
+            if (failed) {
+                return;
+            }
+
+            auto start_time = std::chrono::steady_clock::now();
+            std::string depfile_path = write_depfiles ? variables.expand("$(@:$(obj_ext)=$(depfile_ext))", compilation_job.object_path) : std::string();
+            std::string cache_key;
+            if (compilation_cache) {
+                std::vector<std::filesystem::path> input_paths = compilation_job.source_file->dependencies();
+                input_paths.push_back(compilation_job.source_file->path);
+                cache_key = compilation_cache->key(compilation_job.command, input_paths);
+                if (compilation_cache->restore(cache_key, compilation_job.object_path, depfile_path)) {
+                    ++cache_hits;
+                    build_log.record(compilation_job.object_path, compilation_job.command_hash, compilation_job.duration.value_or(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time)));
+                    print("Restored " + compilation_job.object_path + " from the compilation cache!");
+                    return;
+                }
+                ++cache_misses;
+            }
+
+            print("Compiling " + compilation_job.object_path + " from " + compilation_job.source_path + "...");
+            if (run_process(compilation_job.command) != 0) {
+                print("Error: Failed to compile " + compilation_job.object_path + " from " + compilation_job.source_path);
+                failed = true;
+                return;
+            }
+            if (compilation_cache) {
+                compilation_cache->store(cache_key, compilation_job.object_path, depfile_path);
+            }
+            build_log.record(compilation_job.object_path, compilation_job.command_hash, std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time));
+            print("Finished compiling " + compilation_job.object_path + " from " + compilation_job.source_path + '!');
+        });
+    }
+    pool.wait();
+    build_log.save();
+    if (compilation_cache && !compilation_jobs.empty()) {
+        print("Compilation cache: " + std::to_string(cache_hits) + " hit(s), " + std::to_string(cache_misses) + " miss(es)");
+    }
+    if (failed) {
+        return 1;
+    }
+
+    auto command = variables.expand_command(link_recipe(project), output_path);
+    uint64_t command_hash = hash_command(command);
+    std::vector<std::filesystem::path> input_paths;
+    for (const auto& source_file : project.source_files) {
+        input_paths.push_back(source_file.object_path.generic_string() + obj_ext);
+    }
+    std::istringstream static_libraries(variables.get("static_libraries"));
+    for (std::string static_library; static_libraries >> static_library;) {
+        input_paths.push_back(static_library);
+    }
+    if (!compilation_jobs.empty() || !build_log.is_command_unchanged(output_path, command_hash) || !is_up_to_date(output_path, input_paths)) {
+        print("Building " + output_path + "...");
+        auto start_time = std::chrono::steady_clock::now();
+        if (auto path = std::filesystem::path(output_path); path.has_parent_path()) {
+            std::filesystem::create_directories(path.parent_path(), ec);
+        }
+        if (run_process(command) != 0) {
+            print("Error: Failed to build " + output_path);
+            return 1;
+        }
+        build_log.record(output_path, command_hash, std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time));
+        build_log.save();
+        print("Finished building " + output_path + '!');
+    } else {
+        print(output_path + " is up to date!");
+    }
+    return 0;
 }
 
-int main() {
-    std::cout << log("Converting Polybuild.toml to makefile...") << std::endl;
-    auto config = toml::parse("Polybuild.toml");
-
-    auto paths_table = toml::find(config, "paths");
-    auto output_path = toml::find<std::string>(paths_table, "output");
-    auto source_paths = toml::find<std::vector<std::string>>(paths_table, "source");
-    auto include_paths = toml::find_or<std::vector<std::string>>(paths_table, "include", {});
-    auto library_paths = toml::find_or<std::vector<std::string>>(paths_table, "library", {});
-    auto artifact_path = toml::find<std::string>(paths_table, "artifact");
-    auto install_path = toml::find_or<std::string>(paths_table, "install", {});
-
-    auto options_table = toml::find(config, "options");
-    auto c_compiler = toml::find_or<std::string>(options_table, "c-compiler", "$(CC)");
-    auto cpp_compiler = toml::find_or<std::string>(options_table, "cpp-compiler", toml::find_or<std::string>(options_table, "compiler", "$(CXX)"));
-    auto c_compilation_flags = toml::find_or<std::string>(options_table, "c-compilation-flags", "$(CFLAGS)");
-    auto cpp_compilation_flags = toml::find_or<std::string>(options_table, "cpp-compilation-flags", toml::find_or<std::string>(options_table, "compilation-flags", "$(CXXFLAGS)"));
-    auto link_time_flags = toml::find_or<std::string>(options_table, "link-time-flags", "$(LDFLAGS)");
-    auto libraries = toml::find_or<std::vector<std::string>>(options_table, "libraries", {});
-    auto static_libraries = toml::find_or<std::vector<std::string>>(options_table, "static-libraries", {});
-    auto pkg_config_libraries = toml::find_or<std::vector<std::string>>(options_table, "pkg-config-libraries", {});
-    auto preludes = toml::find_or<std::vector<std::string>>(options_table, "preludes", {});
-    auto clean_preludes = toml::find_or<std::vector<std::string>>(options_table, "clean-preludes", {});
-    auto is_shared = toml::find_or<bool>(options_table, "shared", false);
-    auto is_static = toml::find_or<bool>(options_table, "static", false);
-
-    std::ofstream makefile(".polybuild.mk");
-    makefile << "# This file was auto-generated by Polybuild\n\n";
+int main(int argc, char* argv[]) {
+    bool is_building = false;
+    unsigned int jobs = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        std::string_view value;
+        if (arg == "build" && i == 1) {
+            is_building = true;
+            continue;
+        } else if ((arg == "-j" || arg == "--jobs") && i + 1 < argc) {
+            value = argv[++i];
+        } else if (arg.size() > 2 && arg.substr(0, 2) == "-j") {
+            value = arg.substr(2);
+        } else if (arg.substr(0, 7) == "--jobs=") {
+            value = arg.substr(7);
+        } else {
+            std::cerr << log("Usage: " + std::string(argv[0]) + " [build] [-j N | --jobs N]") << std::endl;
+            return 1;
+        }
+
+        try {
+            jobs = std::stoul(std::string(value));
+        } catch (const std::exception&) {
+            std::cerr << log("Error: Invalid job count: " + std::string(value)) << std::endl;
+            return 1;
+        }
+    }
+
+    PolybuildConfig config;
+    {
+        auto document = toml::parse_lazy("Polybuild.toml");
+        toml::decode_fields(document, config,
+            toml::required_field("paths", &PolybuildConfig::paths),
+            toml::required_field("options", &PolybuildConfig::options),
+            toml::field("env", &PolybuildConfig::env));
+    }
+    auto& paths = config.paths;
+    auto& options = config.options;
+
+    paths.ignore_patterns.push_back(std::filesystem::path(paths.artifact_path).lexically_normal().generic_string()); // Never pick up anything Polybuild generated
+
+    if (options.dependency_mode != "scan" && options.dependency_mode != "compiler") {
+        std::cerr << log("Error: Invalid dependency mode: " + options.dependency_mode + " (expected \"scan\" or \"compiler\")") << std::endl;
+        return 1;
+    }
+    if (options.backend != "make" && options.backend != "ninja") {
+        std::cerr << log("Error: Invalid backend: " + options.backend + " (expected \"make\" or \"ninja\")") << std::endl;
+        return 1;
+    }
+    if (options.unity_batch_size == 0) {
+        std::cerr << log("Error: Invalid unity batch size: 0") << std::endl;
+        return 1;
+    }
+    if (options.pch != "none" && options.pch != "auto") {
+        std::cerr << log("Error: Invalid precompiled header mode: " + options.pch + " (expected \"none\" or \"auto\")") << std::endl;
+        return 1;
+    }
+    if (jobs) {
+        options.scan_jobs = jobs;
+    }
+
+    if (is_building) {
+        std::cout << log("Building from Polybuild.toml...") << std::endl;
+    } else if (options.backend == "ninja") {
+        std::cout << log("Converting Polybuild.toml to build.ninja...") << std::endl;
+    } else {
+        std::cout << log("Converting Polybuild.toml to makefile...") << std::endl;
+    }
 
+    std::ostringstream makefile;
     makefile << "include_path_flag := -I\n";
     makefile << "library_path_flag := -L\n";
     makefile << "obj_path_flag := -o\n";
@@ -149,7 +1698,16 @@ int main() {
     makefile << "link_flag :=\n";
     makefile << "pkg_config_syntax :=\n";
     makefile << "obj_ext := .o\n";
-    if (is_shared) {
+    if (options.dependency_mode == "compiler") {
+        makefile << "depfile_flags := -MMD -MP -MF\n";
+        makefile << "depfile_ext := .d\n";
+    }
+    if (options.pch == "auto") {
+        makefile << "pch_create_flags := -x c++-header\n";
+        makefile << "pch_flags := -include " << (std::filesystem::path(paths.artifact_path) / "pch.hpp").generic_string() << '\n';
+        makefile << "pch_ext := .gch\n";
+    }
+    if (options.is_shared) {
         makefile << "out_ext := .so\n";
     } else {
         makefile << "out_ext :=\n";
@@ -171,7 +1729,16 @@ int main() {
     makefile << "\tlink_flag := /link\n";
     makefile << "\tpkg_config_syntax := --msvc-syntax\n";
     makefile << "\tobj_ext := .obj\n";
-    if (is_shared) {
+    if (options.dependency_mode == "compiler") {
+        makefile << "\tdepfile_flags := /sourceDependencies\n";
+        makefile << "\tdepfile_ext := .json\n";
+    }
+    if (options.pch == "auto") {
+        // Precompiled headers aren't supported with MSVC yet
+        makefile << "\tpch_flags :=\n";
+        makefile << "\tpch_ext :=\n";
+    }
+    if (options.is_shared) {
         makefile << "\tout_ext := .dll\n";
     } else {
         makefile << "\tout_ext := .exe\n";
@@ -189,67 +1756,64 @@ int main() {
     makefile << "\tactive_static_flag := $(debug_static_flag)\n";
     makefile << "endif\n\n";
 
-    makefile << "c_compiler := " << std::quoted(c_compiler) << '\n';
-    makefile << "cpp_compiler := " << std::quoted(cpp_compiler) << '\n';
+    makefile << "c_compiler := " << std::quoted(options.c_compiler) << '\n';
+    makefile << "cpp_compiler := " << std::quoted(options.cpp_compiler) << '\n';
 
-    generate_compilation_flags(makefile, "c_compilation_flags", c_compilation_flags, include_paths, is_shared, is_static, pkg_config_libraries);
-    generate_compilation_flags(makefile, "cpp_compilation_flags", cpp_compilation_flags, include_paths, is_shared, is_static, pkg_config_libraries);
+    generate_compilation_flags(makefile, "c_compilation_flags", options.c_compilation_flags, paths.include_paths, options.is_shared, options.is_static, options.pkg_config_libraries);
+    generate_compilation_flags(makefile, "cpp_compilation_flags", options.cpp_compilation_flags, paths.include_paths, options.is_shared, options.is_static, options.pkg_config_libraries);
 
-    makefile << "link_time_flags := " << link_time_flags << " $(active_debug_link_flag)";
-    for (const auto& library_path : library_paths) {
+    makefile << "link_time_flags := " << options.link_time_flags << " $(active_debug_link_flag)";
+    for (const auto& library_path : paths.library_paths) {
         makefile << " $(library_path_flag)" << std::quoted(library_path);
     }
     makefile << '\n';
 
     makefile << "libraries :=";
-    for (const auto& library : libraries) {
+    for (const auto& library : options.libraries) {
         makefile << " $(library_flag)" << std::quoted(library);
     }
-    if (!pkg_config_libraries.empty()) {
+    if (!options.pkg_config_libraries.empty()) {
         makefile << " `pkg-config $(pkg_config_syntax) --libs";
-        for (const auto& pkg_config_library : pkg_config_libraries) {
+        for (const auto& pkg_config_library : options.pkg_config_libraries) {
             makefile << ' ' << std::quoted(pkg_config_library);
         }
         makefile << '`';
     }
     makefile << '\n';
 
-    if (!static_libraries.empty()) {
+    if (!options.static_libraries.empty()) {
         makefile << "static_libraries :=";
-        for (const auto& static_library : static_libraries) {
+        for (const auto& static_library : options.static_libraries) {
             makefile << ' ' << static_library;
         }
         makefile << '\n';
     }
 
-    if (!install_path.empty()) {
-        makefile << "prefix := " << std::quoted(install_path) << '\n';
+    if (!paths.install_path.empty()) {
+        makefile << "prefix := " << std::quoted(paths.install_path) << '\n';
     }
 
-    auto env_table = toml::find_or<toml::table>(config, "env", {});
-    for (const auto& env_var_table : env_table) {
-        for (const auto& env_var_value_table : env_var_table.second.as_table()) {
-            auto custom_paths_table = toml::find_or(env_var_value_table.second, "paths", {});
-            auto custom_library_paths = toml::find_or<std::vector<std::string>>(custom_paths_table, "library", std::vector<std::string>(library_paths));
-            auto custom_install_path = toml::find_or<std::string>(custom_paths_table, "install", install_path);
+    for (const auto& [env_var, env_var_configs] : config.env) {
+        for (const auto& [env_var_value, env_config] : env_var_configs) {
+            const auto& custom_library_paths = env_config.paths.library_paths ? *env_config.paths.library_paths : paths.library_paths;
+            const auto& custom_install_path = env_config.paths.install_path ? *env_config.paths.install_path : paths.install_path;
 
-            auto custom_options_table = toml::find_or(env_var_value_table.second, "options", {});
-            auto custom_c_compiler = toml::find_or<std::string>(custom_options_table, "c-compiler", c_compiler);
-            auto custom_cpp_compiler = toml::find_or<std::string>(custom_options_table, "cpp-compiler", toml::find_or<std::string>(custom_options_table, "compiler", cpp_compiler));
-            auto custom_c_compilation_flags = toml::find_or<std::string>(custom_options_table, "c-compilation-flags", c_compilation_flags);
-            auto custom_cpp_compilation_flags = toml::find_or<std::string>(custom_options_table, "cpp-compilation-flags", toml::find_or(custom_options_table, "compilation-flags", cpp_compilation_flags));
-            auto custom_link_time_flags = toml::find_or<std::string>(custom_options_table, "link-time-flags", link_time_flags);
-            auto custom_libraries = toml::find_or<std::vector<std::string>>(custom_options_table, "libraries", std::vector<std::string>(libraries));
-            auto custom_pkg_config_libraries = toml::find_or<std::vector<std::string>>(custom_options_table, "pkg-config-libraries", std::vector<std::string>(pkg_config_libraries));
-            auto custom_is_static = toml::find_or<bool>(custom_options_table, "static", is_static);
+            const auto& custom_c_compiler = env_config.options.c_compiler ? *env_config.options.c_compiler : options.c_compiler;
+            const auto& custom_cpp_compiler = env_config.options.cpp_compiler ? *env_config.options.cpp_compiler : options.cpp_compiler;
+            const auto& custom_c_compilation_flags = env_config.options.c_compilation_flags ? *env_config.options.c_compilation_flags : options.c_compilation_flags;
+            const auto& custom_cpp_compilation_flags = env_config.options.cpp_compilation_flags ? *env_config.options.cpp_compilation_flags : options.cpp_compilation_flags;
+            const auto& custom_link_time_flags = env_config.options.link_time_flags ? *env_config.options.link_time_flags : options.link_time_flags;
+            const auto& custom_libraries = env_config.options.libraries ? *env_config.options.libraries : options.libraries;
+            const auto& custom_pkg_config_libraries = env_config.options.pkg_config_libraries ? *env_config.options.pkg_config_libraries : options.pkg_config_libraries;
+            auto custom_is_static = env_config.options.is_static.value_or(options.is_static);
 
-            makefile << "\nifeq ($(" << env_var_table.first << ")," << env_var_value_table.first << ")\n";
+            makefile << "\nifeq ($(" << env_var << ")," << env_var_value << ")\n";
 
             makefile << "\tc_compiler := " << std::quoted(custom_c_compiler) << '\n';
             makefile << "\tcpp_compiler := " << std::quoted(custom_cpp_compiler) << '\n';
 
-            generate_compilation_flags(makefile << '\t', "c_compilation_flags", custom_c_compilation_flags, include_paths, is_shared, custom_is_static, custom_pkg_config_libraries);
-            generate_compilation_flags(makefile << '\t', "cpp_compilation_flags", custom_cpp_compilation_flags, include_paths, is_shared, custom_is_static, custom_pkg_config_libraries);
+            generate_compilation_flags(makefile << '\t', "c_compilation_flags", custom_c_compilation_flags, paths.include_paths, options.is_shared, custom_is_static, custom_pkg_config_libraries);
+            generate_compilation_flags(makefile << '\t', "cpp_compilation_flags", custom_cpp_compilation_flags, paths.include_paths, options.is_shared, custom_is_static, custom_pkg_config_libraries);
 
             makefile << "\tlink_time_flags := " << custom_link_time_flags;
             for (const auto& library_path : custom_library_paths) {
@@ -270,10 +1834,9 @@ int main() {
             }
             makefile << '\n';
 
-            if (custom_options_table.contains("static-libraries")) {
-                auto custom_static_libraries = toml::find<std::vector<std::string>>(custom_options_table, "static-libraries");
+            if (env_config.options.static_libraries) {
                 makefile << "\tstatic_libraries :=";
-                for (const auto& static_library : custom_static_libraries) {
+                for (const auto& static_library : *env_config.options.static_libraries) {
                     makefile << ' ' << static_library;
                 }
                 makefile << '\n';
@@ -287,133 +1850,127 @@ int main() {
         }
     }
 
-    makefile << "\nall: " << output_path << "$(out_ext)\n";
-    makefile << ".PHONY: all\n";
+    Project project;
+    project.output_path = std::move(paths.output_path);
+    project.artifact_path = paths.artifact_path;
+    project.preludes = std::move(options.preludes);
+    project.clean_preludes = std::move(options.clean_preludes);
+    project.dependency_mode = options.dependency_mode;
+    project.variable_definitions = makefile.str();
 
-    std::vector<std::filesystem::path> object_paths;
-    bool has_cpp = false;
-    for (std::filesystem::path source_path : source_paths) {
-        for (std::filesystem::directory_entry entry : SortedDirectoryIterator(source_path)) {
+    auto& source_files = project.source_files;
+    std::unordered_map<std::string, unsigned int> object_indices; // Maps each stem to the index its next object will get
+    ThreadPool pool(options.scan_jobs);
+    for (std::filesystem::path source_path : paths.source_paths) {
+        for (std::filesystem::directory_entry entry : SortedDirectoryIterator(source_path, paths.is_recursive, paths.ignore_patterns, pool)) {
             if (SourceFileType file_type; entry.is_regular_file() && (file_type = get_source_file_type(entry.path())) != SOURCE_FILE_NONE) {
-                std::filesystem::path object_path;
-                for (unsigned int i = 0;; ++i) {
-                    object_path = (std::filesystem::path(artifact_path) / (entry.path().stem().string() + '_' + std::to_string(i)));
-                    if (std::find(object_paths.begin(), object_paths.end(), object_path) != object_paths.end()) {
-                        continue;
-                    } else {
-                        object_paths.push_back(object_path);
-                        break;
-                    }
-                }
-                makefile << '\n'
-                         << object_path.generic_string() << "$(obj_ext): " << entry.path().generic_string() << " .polybuild.mk";
-
-                std::vector<std::filesystem::path> dependencies;
-                find_dependencies(entry.path(), include_paths, dependencies);
-                for (const auto& depdendency : dependencies) {
-                    makefile << ' ' << depdendency.generic_string();
-                }
-                makefile << '\n';
-
-                makefile << '\t' << echo("Compiling $@ from $<...") << '\n';
-                makefile << "\t@mkdir -p " << artifact_path << '\n';
-                if (file_type == SOURCE_FILE_CPP) {
-                    makefile << "\t@$(cpp_compiler) $(compile_only_flag) $< $(cpp_compilation_flags) $(obj_path_flag)$@\n";
-                    has_cpp = true;
-                } else {
-                    makefile << "\t@$(c_compiler) $(compile_only_flag) $< $(c_compilation_flags) $(obj_path_flag)$@\n";
-                }
-                makefile << '\t' << echo("Finished compiling $@ from $<!") << '\n';
+                // Since indices only contain digits, stem + '_' + index can never collide with the name of another stem's object
+                std::string stem = entry.path().stem().string();
+                unsigned int index = object_indices[stem]++;
+                auto object_path = std::filesystem::path(paths.artifact_path) / (stem + '_' + std::to_string(index));
+                source_files.push_back({entry.path(), std::move(object_path), file_type, {}, {}, false});
             }
         }
     }
 
-    makefile << "\nobjects := ";
-    for (const auto& object_path : object_paths) {
-        makefile << ' ' << object_path.generic_string() << "$(obj_ext)";
-    }
-    makefile << '\n';
-
-    makefile << output_path << "$(out_ext): .polybuild.mk $(objects) $(static_libraries)\n";
-    makefile << "\t" << echo("Building $@...") << '\n';
-    {
-        auto path = std::filesystem::path(output_path);
-        if (path.has_parent_path()) {
-            makefile << "\t@mkdir -p " << path.parent_path().generic_string() << '\n';
+    // The compilation cache needs the scanned dependencies to key objects, while unity builds and precompiled headers need them to pick sources and headers, whatever the dependency mode
+    if (((is_building || options.backend == "make") && options.dependency_mode == "scan") || (is_building && options.has_compilation_cache) || options.is_unity || options.pch == "auto") {
+        DependencyCache dependency_cache(std::filesystem::path(paths.artifact_path) / ".polybuild-deps.cache");
+        DependencyGraph dependency_graph(paths.include_paths, dependency_cache);
+        for (auto& source_file : source_files) {
+            pool.schedule([&dependency_graph, &source_file]() {
+                source_file.dependency_list = dependency_graph.find_dependencies(source_file.path);
+            });
         }
-    }
-    if (has_cpp) {
-        makefile << "\t@$(cpp_compiler) $(objects) $(static_libraries) $(cpp_compilation_flags) $(out_path_flag)$@ $(link_flag) $(link_time_flags) $(libraries)\n\t" << echo("Finished building $@!") << '\n';
-    } else {
-        makefile << "\t@$(c_compiler) $(objects) $(static_libraries) $(c_compilation_flags) $(out_path_flag)$@ $(link_flag) $(link_time_flags) $(libraries)\n\t" << echo("Finished building $@!") << '\n';
+        pool.wait();
+        dependency_cache.save();
     }
 
-    makefile << "\nclean:";
-    for (const auto& clean_prelude : clean_preludes) {
-        makefile << "\n\t" << echo("Executing clean prelude: " + clean_prelude);
-        makefile << "\n\t@" << clean_prelude;
+    if (options.is_unity) {
+        group_unity_sources(source_files, paths.artifact_path, options.unity_batch_size, options.unity_exclude_patterns, object_indices);
     }
-    makefile << "\n\t" << echo("Deleting " + output_path + "$(out_ext) and " + artifact_path + "...") << '\n';
-    makefile << "\t@rm -rf " << output_path << "$(out_ext) " << artifact_path << '\n';
-    makefile << '\t' << echo("Finished deleting " + output_path + "$(out_ext) and " + artifact_path + '!') << '\n';
-    makefile << ".PHONY: clean\n";
-
-    makefile << "\ninstall:\n";
-    makefile << '\t' << echo("Copying " + output_path + "$(out_ext) to $(prefix)...") << '\n';
-    makefile << "\t@cp " << output_path << "$(out_ext) $(prefix)\n";
-    makefile << '\t' << echo("Finished copying " + output_path + "$(out_ext) to $(prefix)!") << '\n';
-    makefile << ".PHONY: install\n";
-
-    makefile.close();
-    std::cout << log("Finished converting Polybuild.toml to makefile!") << std::endl;
 
-    std::cout << log("Producing makefile wrapper...") << std::endl;
-    std::ofstream wrapper("Makefile");
-    wrapper << "# This file was auto-generated by Polybuild\n\n";
-
-    wrapper << "ifndef MODE\n";
-    wrapper << "\tMODE := release\n";
-    wrapper << "\texport MODE\n";
-    wrapper << "endif\n\n";
-
-    wrapper << "ifndef OS\n";
-    wrapper << "\tOS := $(shell uname)\n";
-    wrapper << "\texport OS\n";
-    wrapper << "endif\n\n";
-
-    wrapper << "ifeq ($(OS),Windows_NT)\n";
-    wrapper << "\tCC := cl\n";
-    wrapper << "\tCXX := cl\n";
-    wrapper << "\tCL := /nologo\n";
-    wrapper << "\tLINK := /nologo\n";
-    wrapper << "\tMSYS_NO_PATHCONV := 1\n";
-    wrapper << "\texport CC CXX CL MSYS_NO_PATHCONV\n";
-    wrapper << "endif\n";
+    if (options.pch == "auto") {
+        if (auto headers = choose_precompiled_headers(source_files, options.pch_threshold); !headers.empty()) {
+            SourceFile precompiled_header;
+            precompiled_header.path = std::filesystem::path(paths.artifact_path) / "pch.hpp";
+            precompiled_header.object_path = precompiled_header.path;
+            precompiled_header.type = SOURCE_FILE_CPP;
+            precompiled_header.unity_members = headers;
 
-    wrapper << "\nall:";
-    for (unsigned int i = 0; i < preludes.size(); ++i) {
-        wrapper << " prelude" << i;
+            // Every user includes all of the chosen headers, so the headers all users have in common include everything the chosen headers depend on
+            std::unordered_map<std::string, unsigned int> user_counts;
+            unsigned int user_count = 0;
+            for (const auto& source_file : source_files) {
+                if (source_file.uses_precompiled_header) {
+                    std::unordered_set<std::string> dependencies;
+                    for (const auto& dependency : source_file.dependencies()) {
+                        if (std::string normal_path = dependency.lexically_normal().generic_string(); dependencies.insert(normal_path).second) {
+                            ++user_counts[normal_path];
+                        }
+                    }
+                    ++user_count;
+                }
+            }
+            std::vector<std::filesystem::path> dependencies;
+            for (const auto& source_file : source_files) {
+                if (source_file.uses_precompiled_header) {
+                    for (const auto& dependency : source_file.dependencies()) {
+                        if (auto user_count_it = user_counts.find(dependency.lexically_normal().generic_string()); user_count_it != user_counts.end() && user_count_it->second == user_count) {
+                            dependencies.push_back(dependency.lexically_normal());
+                            user_counts.erase(user_count_it);
+                        }
+                    }
+                    break;
+                }
+            }
+            precompiled_header.dependency_list = std::make_shared<const std::vector<std::filesystem::path>>(std::move(dependencies));
+            project.precompiled_header = std::move(precompiled_header);
+        }
     }
-    wrapper << "\n\t@\"$(MAKE)\" -f .polybuild.mk --no-print-directory\n";
-    wrapper << ".PHONY: all\n";
 
-    for (unsigned int i = 0; i < preludes.size(); ++i) {
-        wrapper << "\nprelude" << i << ":\n";
-        wrapper << '\t' << echo("Executing prelude: " + preludes[i]) << '\n';
-        wrapper << "\t@" << preludes[i] << '\n';
-        wrapper << ".PHONY: prelude" << i << '\n';
+    if (is_building) {
+        if (options.has_compilation_cache) {
+            if (auto cache_path = CompilationCache::default_path(); !cache_path.empty()) {
+                CompilationCache compilation_cache(std::move(cache_path));
+                return build_project(project, MakeVariables(project.variable_definitions), jobs ? jobs : std::thread::hardware_concurrency(), &compilation_cache);
+            }
+            std::cerr << log("Warning: Couldn't find a directory for the compilation cache, so it won't be used") << std::endl;
+        }
+        return build_project(project, MakeVariables(project.variable_definitions), jobs ? jobs : std::thread::hardware_concurrency());
     }
 
-    wrapper << "\nclean:\n";
-    wrapper << "\t@\"$(MAKE)\" -f .polybuild.mk --no-print-directory $@\n";
-    wrapper << ".PHONY: clean\n";
+    if (options.backend == "ninja") {
+        if (write_file_if_changed("build.ninja", generate_ninja(project, MakeVariables(project.variable_definitions)))) {
+            std::cout << log("Finished converting Polybuild.toml to build.ninja!") << std::endl;
+        } else {
+            std::cout << log("Finished converting Polybuild.toml to build.ninja (unchanged)!") << std::endl;
+        }
+    } else {
+        if (write_file_if_changed(".polybuild.mk", [&project](std::ostream& os) {
+                generate_makefile(os, project);
+            })) {
+            std::cout << log("Finished converting Polybuild.toml to makefile!") << std::endl;
+        } else {
+            std::cout << log("Finished converting Polybuild.toml to makefile (unchanged)!") << std::endl;
+        }
 
-    wrapper << "\ninstall:\n";
-    wrapper << "\t@\"$(MAKE)\" -f .polybuild.mk --no-print-directory $@\n";
-    wrapper << ".PHONY: install\n";
+        std::cout << log("Producing makefile wrapper...") << std::endl;
+        if (write_file_if_changed("Makefile", generate_wrapper(project))) {
+            std::cout << log("Finished producing makefile wrapper!") << std::endl;
+        } else {
+            std::cout << log("Finished producing makefile wrapper (unchanged)!") << std::endl;
+        }
+    }
 
-    wrapper.close();
-    std::cout << log("Finished producing makefile wrapper!") << std::endl;
+    if (options.has_compilation_database) {
+        std::cout << log("Producing compilation database...") << std::endl;
+        if (write_file_if_changed("compile_commands.json", generate_compilation_database(project, MakeVariables(project.variable_definitions)))) {
+            std::cout << log("Finished producing compilation database!") << std::endl;
+        } else {
+            std::cout << log("Finished producing compilation database (unchanged)!") << std::endl;
+        }
+    }
 
     return 0;
 }
@@ -0,0 +1,42 @@
+#include "test.hpp"
+#include "toml.hpp"
+#include <sstream>
+#include <string>
+#include <utility>
+
+static toml::arena_value parse_arena(const std::string& document) {
+    std::istringstream ss(document);
+    return toml::parse<toml::discard_comments, toml::arena_unordered_map, toml::arena_vector>(ss, "arena.toml");
+}
+
+TEST(arena_value_parses_like_value) {
+    auto data = parse_arena("a = 1\n[t]\nx = [1, 2, 3]\ny = {z = 'w'}\n[[arr]]\nk = 1\n[[arr]]\nk = 2\n");
+    CHECK_EQ(toml::find<int>(data, "a"), 1);
+    CHECK_EQ(toml::find<int>(data, "t", "x", 2), 3);
+    CHECK_EQ(toml::find<std::string>(data, "t", "y", "z"), "w");
+    CHECK_EQ(toml::find<int>(data, "arr", 1, "k"), 2);
+
+    // Tables and arrays come from the document's arena, unlike ones made outside of a parse
+    CHECK(data.as_table().get_allocator() == toml::find(data, "t").as_table().get_allocator());
+    CHECK(data.as_table().get_allocator() != toml::arena_value::table_type().get_allocator());
+}
+
+TEST(arena_value_outlives_its_document) {
+    toml::arena_value copy;
+    toml::arena_value moved;
+    {
+        auto data = parse_arena("[t]\nx = [1, 2, 3]\n[u]\ny = 'long enough to be on the heap, not inline'\n");
+        copy = toml::find(data, "t");
+        moved = std::move(data.as_table().at("u"));
+    }
+    copy.as_table()["z"] = toml::arena_value(4);
+    moved.as_table()["z"] = toml::arena_value(5);
+    CHECK_EQ(toml::find<int>(copy, "x", 1), 2);
+    CHECK_EQ(toml::find<int>(copy, "z"), 4);
+    CHECK_EQ(toml::find<std::string>(moved, "y"), "long enough to be on the heap, not inline");
+    CHECK_EQ(toml::find<int>(moved, "z"), 5);
+
+    // Copies made after parsing are on the heap, while moved tables keep their arena
+    CHECK(copy.as_table().get_allocator() == toml::arena_value::table_type().get_allocator());
+    CHECK(moved.as_table().get_allocator() != toml::arena_value::table_type().get_allocator());
+}
@@ -0,0 +1,111 @@
+#include "test.hpp"
+#include "toml.hpp"
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+struct Server {
+    std::string host = "localhost";
+    uint16_t port = 8080;
+    std::vector<std::string> routes;
+    std::optional<double> timeout;
+};
+
+namespace toml {
+    template <>
+    struct from<Server> {
+        static Server from_toml(const value& v) {
+            Server ret;
+            decode_fields(v, ret,
+                required_field("host", &Server::host),
+                field("port", &Server::port),
+                field("routes", &Server::routes),
+                field("timeout", &Server::timeout));
+            return ret;
+        }
+    };
+} // namespace toml
+
+static toml::value parse(const std::string& document) {
+    std::istringstream ss(document);
+    return toml::parse(ss);
+}
+
+TEST(decode_fields_reads_present_fields_and_keeps_defaults) {
+    auto server = toml::find<Server>(parse("[server]\nhost = \"example.com\"\nroutes = [\"/\", \"/api\"]\n"), "server");
+    CHECK_EQ(server.host, "example.com");
+    CHECK_EQ(server.port, 8080);
+    CHECK_EQ(server.routes, (std::vector<std::string> {"/", "/api"}));
+    CHECK(!server.timeout);
+
+    server = toml::find<Server>(parse("[server]\nhost = \"h\"\nport = 443\ntimeout = 2.5\n"), "server");
+    CHECK_EQ(server.port, 443);
+    CHECK(server.timeout && *server.timeout == 2.5);
+}
+
+TEST(decode_fields_reports_missing_and_mistyped_fields) {
+    CHECK_THROWS(toml::find<Server>(parse("[server]\nport = 1\n"), "server"), std::out_of_range);
+    CHECK_THROWS(toml::find<Server>(parse("[server]\nhost = 1\n"), "server"), toml::type_error);
+    CHECK_THROWS(toml::find<Server>(parse("[server]\nhost = \"h\"\nroutes = \"/\"\n"), "server"), toml::type_error);
+}
+
+TEST(decode_fields_lets_later_bindings_win) {
+    struct Options {
+        std::string compiler = "cc";
+    } options;
+    auto data = parse("compiler = \"g++\"\ncpp-compiler = \"clang++\"\n");
+    toml::decode_fields(data, options,
+        toml::field("compiler", &Options::compiler),
+        toml::field("cpp-compiler", &Options::compiler));
+    CHECK_EQ(options.compiler, "clang++");
+
+    options.compiler = "cc";
+    data = parse("compiler = \"g++\"\n");
+    toml::decode_fields(data, options,
+        toml::field("compiler", &Options::compiler),
+        toml::field("cpp-compiler", &Options::compiler));
+    CHECK_EQ(options.compiler, "g++");
+}
+
+TEST(decode_fields_parses_only_bound_lazy_entries) {
+    struct Config {
+        std::string name;
+        int count = 0;
+    } config;
+    TemporaryFile file("binding.toml",
+        "name = \"polybuild\"\n"
+        "count = 3\n"
+        "broken = [1, 2,, 3]\n");
+    auto doc = toml::parse_lazy(file.path().string());
+    toml::decode_fields(doc, config,
+        toml::required_field("name", &Config::name),
+        toml::field("count", &Config::count));
+    CHECK_EQ(config.name, "polybuild");
+    CHECK_EQ(config.count, 3);
+
+    struct Broken {
+        std::vector<int> broken;
+    } broken;
+    CHECK_THROWS(toml::decode_fields(doc, broken, toml::field("broken", &Broken::broken)), toml::syntax_error);
+}
+
+TEST(encode_fields_round_trips) {
+    Server server;
+    server.host = "example.com";
+    server.routes = {"/"};
+    auto v = toml::encode_fields(server,
+        toml::field("host", &Server::host),
+        toml::field("port", &Server::port),
+        toml::field("routes", &Server::routes),
+        toml::field("timeout", &Server::timeout));
+    CHECK(!v.contains("timeout"));
+
+    auto decoded = toml::get<Server>(v);
+    CHECK_EQ(decoded.host, server.host);
+    CHECK_EQ(decoded.port, server.port);
+    CHECK_EQ(decoded.routes, server.routes);
+    CHECK(!decoded.timeout);
+}
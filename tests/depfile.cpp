@@ -0,0 +1,54 @@
+#include "test.hpp"
+#include "util.hpp"
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using Paths = std::vector<std::filesystem::path>;
+
+TEST(read_depfile_reads_the_first_rule) {
+    TemporaryFile depfile("rule.d",
+        "obj/main.o: src/main.cpp src/a.hpp \\\n"
+        "  src/b.hpp\n"
+        "src/a.hpp:\n"
+        "src/b.hpp:\n");
+    CHECK_EQ(read_depfile(depfile.path()), (Paths {"src/main.cpp", "src/a.hpp", "src/b.hpp"}));
+}
+
+TEST(read_depfile_unescapes_make_syntax) {
+    TemporaryFile depfile("escapes.d",
+        "obj/main.o: src/with\\ space.hpp src/hash\\#.hpp src/dollar$$.hpp \\\r\n"
+        " C:/include/windows.h");
+    CHECK_EQ(read_depfile(depfile.path()), (Paths {"src/with space.hpp", "src/hash#.hpp", "src/dollar$.hpp", "C:/include/windows.h"}));
+}
+
+TEST(read_depfile_handles_missing_or_empty_files) {
+    CHECK_EQ(read_depfile(std::filesystem::temp_directory_path() / "polybuild-tests-missing.d"), Paths {});
+    TemporaryFile depfile("empty.d", "");
+    CHECK_EQ(read_depfile(depfile.path()), Paths {});
+}
+
+TEST(read_depfile_reads_msvc_json_depfiles) {
+    TemporaryFile depfile("main.obj.json",
+        "{\n"
+        "    \"Version\": \"1.1\",\n"
+        "    \"Data\": {\n"
+        "        \"Source\": \"c:\\\\src\\\\main.cpp\",\n"
+        "        \"ProvidedModule\": \"\",\n"
+        "        \"Includes\": [\n"
+        "            \"c:\\\\src\\\\a.hpp\",\n"
+        "            \"c:\\/src\\/b.hpp\"\n"
+        "        ],\n"
+        "        \"ImportedModules\": []\n"
+        "    }\n"
+        "}\n");
+    CHECK_EQ(read_depfile(depfile.path()), (Paths {"c:\\src\\a.hpp", "c:/src/b.hpp"}));
+}
+
+TEST(read_json_depfile_decodes_escapes) {
+    CHECK_EQ(read_json_depfile(R"({"Data": {"Includes": ["caf\u00e9.h", "\ud83d\ude00.h", "tab\t.h"]}})"),
+        (Paths {std::filesystem::u8path("caf\xc3\xa9.h"), std::filesystem::u8path("\xf0\x9f\x98\x80.h"), "tab\t.h"}));
+    CHECK_EQ(read_json_depfile(R"({"Data": {"Includes": []}})"), Paths {});
+    CHECK_EQ(read_json_depfile(R"({"Data": {"Source": "main.cpp"}})"), Paths {});
+    CHECK_EQ(read_json_depfile(R"({"Data": {"Includes": ["a.h", "unterminated)"), Paths {"a.h"});
+}
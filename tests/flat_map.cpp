@@ -0,0 +1,100 @@
+#include "test.hpp"
+#include "toml.hpp"
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using FlatMap = toml::flat_map<std::string, int>;
+
+template <typename Map>
+static std::vector<std::pair<std::string, int>> items(const Map& map) {
+    return {map.begin(), map.end()};
+}
+
+TEST(flat_map_keeps_keys_sorted_and_unique) {
+    FlatMap map;
+    CHECK(map.insert({"b", 2}).second);
+    CHECK(map.insert({"a", 1}).second);
+    CHECK(map.insert({"c", 3}).second);
+    CHECK(!map.insert({"a", 10}).second);
+    CHECK(!map.try_emplace("b", 20).second);
+    CHECK(!map.insert_or_assign("c", 30).second);
+    map["d"] = 4;
+    CHECK_EQ(items(map), (std::vector<std::pair<std::string, int>> {{"a", 1}, {"b", 2}, {"c", 30}, {"d", 4}}));
+
+    CHECK_EQ(map.at("b"), 2);
+    CHECK_THROWS(map.at("z"), std::out_of_range);
+    CHECK(map.contains("d"));
+    CHECK(map.find("bb") == map.end());
+    CHECK_EQ(map.lower_bound("bb")->first, "c");
+    CHECK_EQ(map.upper_bound("c")->first, "d");
+    CHECK_EQ(map.erase("a"), 1u);
+    CHECK_EQ(map.erase("a"), 0u);
+    CHECK_EQ(map.size(), 3u);
+}
+
+TEST(flat_map_range_insert_keeps_the_first_duplicate) {
+    FlatMap map {{"b", 1}};
+    std::vector<std::pair<std::string, int>> range {{"c", 1}, {"a", 1}, {"b", 2}, {"a", 2}, {"c", 2}};
+    map.insert(range.begin(), range.end());
+    CHECK_EQ(items(map), (std::vector<std::pair<std::string, int>> {{"a", 1}, {"b", 1}, {"c", 1}}));
+}
+
+TEST(flat_map_behaves_like_std_map) {
+    std::mt19937 rng(42);
+    FlatMap flat;
+    std::map<std::string, int> reference;
+    for (int i = 0; i < 20000; ++i) {
+        std::string key = std::to_string(rng() % 500);
+        int value = (int) (rng() % 1000);
+        switch (rng() % 5) {
+        case 0:
+            CHECK_EQ(flat.insert({key, value}).second, reference.insert({key, value}).second);
+            break;
+        case 1:
+            flat[key] = value;
+            reference[key] = value;
+            break;
+        case 2:
+            CHECK_EQ(flat.erase(key), reference.erase(key));
+            break;
+        case 3:
+            CHECK_EQ(flat.count(key), reference.count(key));
+            break;
+        case 4:
+            flat.insert_or_assign(key, value);
+            reference.insert_or_assign(key, value);
+            break;
+        }
+    }
+    CHECK_EQ(items(flat), items(reference));
+}
+
+TEST(flat_map_works_as_a_toml_table) {
+    using value = toml::basic_value<toml::discard_comments, toml::flat_map>;
+    std::istringstream ss(
+        "z = 1\n"
+        "a = \"x\"\n"
+        "[table]\n"
+        "m = [1, 2]\n"
+        "b.c = true\n");
+    auto data = toml::parse<toml::discard_comments, toml::flat_map>(ss);
+    CHECK_EQ(toml::find<int>(data, "z"), 1);
+    CHECK_EQ(toml::find<std::string>(data, "a"), "x");
+    CHECK_EQ(toml::find<std::vector<int>>(data, "table", "m"), (std::vector<int> {1, 2}));
+    CHECK(toml::find<bool>(data, "table", "b", "c"));
+
+    std::vector<std::string> keys;
+    for (const auto& kv : data.as_table()) {
+        keys.push_back(kv.first);
+    }
+    CHECK_EQ(keys, (std::vector<std::string> {"a", "table", "z"}));
+
+    value copy = data;
+    CHECK(copy == data);
+    copy.as_table().erase("z");
+    CHECK(copy != data);
+}
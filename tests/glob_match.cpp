@@ -0,0 +1,33 @@
+#include "test.hpp"
+#include "util.hpp"
+
+TEST(glob_match_matches_literals) {
+    CHECK(glob_match("src/main.cpp", "src/main.cpp"));
+    CHECK(!glob_match("src/main.cpp", "src/main.c"));
+    CHECK(!glob_match("src/main.c", "src/main.cpp"));
+    CHECK(glob_match("", ""));
+    CHECK(!glob_match("", "a"));
+}
+
+TEST(glob_match_stops_single_wildcards_at_slashes) {
+    CHECK(glob_match("*.cpp", "main.cpp"));
+    CHECK(glob_match("*.cpp", ".cpp"));
+    CHECK(!glob_match("*.cpp", "src/main.cpp"));
+    CHECK(glob_match("src/*", "src/main.cpp"));
+    CHECK(!glob_match("src/*", "src/a/main.cpp"));
+    CHECK(glob_match("src/*_test.cpp", "src/util_test.cpp"));
+    CHECK(glob_match("?.c", "a.c"));
+    CHECK(!glob_match("?.c", "ab.c"));
+    CHECK(!glob_match("a?b", "a/b"));
+}
+
+TEST(glob_match_crosses_slashes_with_double_wildcards) {
+    CHECK(glob_match("**/*_test.cpp", "util_test.cpp"));
+    CHECK(glob_match("**/*_test.cpp", "src/a/b/util_test.cpp"));
+    CHECK(!glob_match("**/*_test.cpp", "src/util.cpp"));
+    CHECK(glob_match("third_party/**", "third_party/a/b.c"));
+    CHECK(glob_match("src/**/gen/*.cpp", "src/gen/a.cpp"));
+    CHECK(glob_match("src/**/gen/*.cpp", "src/x/y/gen/a.cpp"));
+    CHECK(!glob_match("src/**/gen/*.cpp", "src/x/gen/y/a.cpp"));
+    CHECK(glob_match("**", "a/b/c"));
+}
@@ -0,0 +1,98 @@
+#include "test.hpp"
+#include <atomic>
+#include <exception>
+#include <iostream>
+#include <new>
+#include <stdlib.h>
+#include <string>
+#include <string_view>
+#ifdef _WIN32
+    #include <malloc.h>
+    #define malloc_usable_size _msize
+#elif defined(__APPLE__)
+    #include <malloc/malloc.h>
+    #define malloc_usable_size malloc_size
+#else
+    #include <malloc.h>
+#endif
+
+// Unit tests for Polybuild's helpers and the vendored toml parser, run from this directory after building Polybuild itself
+// Pass a name to run only the tests whose names contain it
+
+// operator new and delete allocate with malloc and free like the default ones, and count the usable size of each block while an AllocationCounter exists
+// Blocks allocated before counting started may be freed while it's on, so the live count can drop below zero
+static std::atomic<bool> counting_allocations = false;
+static std::atomic<long long> live_allocated_bytes = 0;
+static std::atomic<long long> peak_allocated_bytes = 0;
+
+void* operator new(size_t size) {
+    void* ret = malloc(size ? size : 1);
+    if (!ret) {
+        throw std::bad_alloc();
+    }
+    if (counting_allocations) {
+        long long live = live_allocated_bytes += malloc_usable_size(ret);
+        for (long long peak = peak_allocated_bytes; live > peak && !peak_allocated_bytes.compare_exchange_weak(peak, live);) {}
+    }
+    return ret;
+}
+
+void operator delete(void* ptr) noexcept {
+    if (ptr && counting_allocations) {
+        live_allocated_bytes -= malloc_usable_size(ptr);
+    }
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    operator delete(ptr);
+}
+
+AllocationCounter::AllocationCounter() {
+    live_allocated_bytes = 0;
+    peak_allocated_bytes = 0;
+    counting_allocations = true;
+}
+
+AllocationCounter::~AllocationCounter() {
+    counting_allocations = false;
+}
+
+size_t AllocationCounter::peak_bytes() const {
+    return peak_allocated_bytes;
+}
+
+std::string log(const std::string& str) {
+    return "\033[1m[POLYBUILD-TESTS]\033[0m " + str;
+}
+
+int main(int argc, char* argv[]) {
+    std::string_view filter = argc > 1 ? argv[1] : "";
+
+    unsigned int run_count = 0;
+    unsigned int failed_count = 0;
+    for (const auto& test_case : test_cases()) {
+        if (std::string_view(test_case.name).find(filter) == std::string_view::npos) {
+            continue;
+        }
+
+        unsigned int failures_before = failure_count();
+        try {
+            test_case.run();
+        } catch (const std::exception& e) {
+            report_failure(test_case.name, 0, std::string("Uncaught exception: ") + e.what());
+        }
+        ++run_count;
+        if (failure_count() != failures_before) {
+            std::cerr << log("Failed " + std::string(test_case.name)) << std::endl;
+            ++failed_count;
+        }
+    }
+
+    if (failed_count) {
+        std::cerr << log("Error: " + std::to_string(failed_count) + " of " + std::to_string(run_count) + " tests failed") << std::endl;
+        return 1;
+    }
+    std::cout << log("All " + std::to_string(run_count) + " tests passed") << std::endl;
+    return 0;
+}
@@ -0,0 +1,124 @@
+#include "test.hpp"
+#include "toml.hpp"
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Writes everything it is told into one string per event
+struct RecordingHandler: toml::event_handler {
+    std::vector<std::string> events;
+    size_t stop_after = -1;
+
+    static std::string join(const std::vector<toml::key>& keys) {
+        std::string ret;
+        for (const auto& key : keys) {
+            ret += (ret.empty() ? "" : ".") + key;
+        }
+        return ret;
+    }
+
+    bool record(std::string event) {
+        events.push_back(std::move(event));
+        return events.size() < stop_after;
+    }
+
+    bool on_table_header(const std::vector<toml::key>& keys, const toml::source_location&) {
+        return record("[" + join(keys) + "]");
+    }
+    bool on_array_table_header(const std::vector<toml::key>& keys, const toml::source_location&) {
+        return record("[[" + join(keys) + "]]");
+    }
+    bool on_key(const std::vector<toml::key>& keys, const toml::source_location&) {
+        return record(join(keys) + " =");
+    }
+    bool on_value(const toml::value& value) {
+        std::ostringstream ss;
+        ss << value;
+        return record(ss.str());
+    }
+    bool on_array_begin(const toml::source_location&) {
+        return record("[");
+    }
+    bool on_array_end(const toml::source_location&) {
+        return record("]");
+    }
+    bool on_inline_table_begin(const toml::source_location&) {
+        return record("{");
+    }
+    bool on_inline_table_end(const toml::source_location&) {
+        return record("}");
+    }
+};
+
+static std::vector<std::string> parse_events(const std::string& document, size_t stop_after = -1) {
+    RecordingHandler handler;
+    handler.stop_after = stop_after;
+    std::istringstream ss(document);
+    toml::parse_events(ss, handler);
+    return handler.events;
+}
+
+using Events = std::vector<std::string>;
+
+TEST(parse_events_reports_every_component) {
+    std::string document =
+        "# comment\n"
+        "title = \"x\"\n"
+        "a.\"b c\" = [1, [true], {d = 2.5}]\n"
+        "\n"
+        "[table.sub]   # comment\n"
+        "  key = 1979-05-27\n"
+        "[[array]]\n"
+        "[\"quoted\"]\n";
+    CHECK_EQ(parse_events(document), (Events {
+        "title =", "\"x\"",
+        "a.b c =", "[", "1", "[", "true", "]", "{", "d =", "2.5", "}", "]",
+        "[table.sub]", "key =", "1979-05-27",
+        "[[array]]",
+        "[quoted]",
+    }));
+}
+
+TEST(parse_events_stops_when_the_handler_returns_false) {
+    RecordingHandler handler;
+    handler.stop_after = 3;
+    std::istringstream ss("a = 1\n[b]\nc = 2\n");
+    CHECK(!toml::parse_events(ss, handler));
+    CHECK_EQ(handler.events, (Events {"a =", "1", "[b]"}));
+}
+
+TEST(parse_events_throws_syntax_errors) {
+    CHECK_THROWS(parse_events("[table\n"), toml::syntax_error);
+    CHECK_THROWS(parse_events("[[array]\n"), toml::syntax_error);
+    CHECK_THROWS(parse_events("key = \n"), toml::syntax_error);
+    CHECK_THROWS(parse_events("a = 1 b = 2\n"), toml::syntax_error);
+    CHECK_THROWS(parse_events("a = [1, 2\n"), toml::syntax_error);
+}
+
+#ifdef TOML11_HAS_MMAP
+// Files are mapped rather than read where that is supported, so the memory parse_events needs doesn't depend on their size
+TEST(parse_events_uses_bounded_memory) {
+    auto peak_memory = [](size_t value_count) {
+        std::string document = "values = [\n";
+        for (size_t i = 0; i < value_count; ++i) {
+            document += std::to_string(i) + ",\n";
+        }
+        document += "]\n";
+        for (size_t i = 0; i < value_count / 100; ++i) {
+            document += "[table" + std::to_string(i) + "]\nkey = \"value\"\n";
+        }
+        TemporaryFile file("events.toml", document);
+        document.clear();
+        document.shrink_to_fit();
+
+        toml::event_handler handler;
+        AllocationCounter counter;
+        toml::parse_events(file.path().string(), handler);
+        return counter.peak_bytes();
+    };
+
+    size_t small = peak_memory(10000);
+    size_t large = peak_memory(200000);
+    CHECK(large <= small + 1024);
+}
+#endif
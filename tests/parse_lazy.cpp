@@ -0,0 +1,76 @@
+#include "test.hpp"
+#include "toml.hpp"
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static const char* const tricky_document =
+    "# a comment for the file\n"
+    "\n"
+    "title = \"[not a table]\" # [nor this]\n"
+    "dotted.key = 1\n"
+    "dotted.other = 'x # y'\n"
+    "multiline = [\n"
+    "    1, # one\n"
+    "    [2, 3],\n"
+    "]\n"
+    "text = \"\"\"\n"
+    "[still text]\n"
+    "key = \"\"\"\n"
+    "inline = {a = {b = \"}\"}}\n"
+    "\n"
+    "[server.http]\n"
+    "port = 80\n"
+    "[[workers]]\n"
+    "name = \"a\"\n"
+    "[client]\n"
+    "retries = 3\n"
+    "[server]\n"
+    "host = \"localhost\"\n"
+    "[[workers]]\n"
+    "name = \"b\"\n"
+    "[\"quoted key\"]\n"
+    "x = 1";
+
+TEST(parse_lazy_matches_parse) {
+    TemporaryFile file("lazy.toml", tricky_document);
+    auto doc = toml::parse_lazy<toml::discard_comments>(file.path().string());
+    CHECK_EQ(doc.keys(), (std::vector<toml::key> {"client", "dotted", "inline", "multiline", "quoted key", "server", "text", "title", "workers"}));
+
+    auto expected = toml::parse<toml::discard_comments>(file.path().string());
+    CHECK(doc.value() == expected);
+}
+
+TEST(parse_lazy_finds_entries_on_demand) {
+    TemporaryFile file("lazy.toml", tricky_document);
+    auto doc = toml::parse_lazy(file.path().string());
+    CHECK_EQ(toml::find<std::string>(doc, "title"), "[not a table]");
+    CHECK_EQ(toml::find<int>(doc, "server", "http", "port"), 80);
+    CHECK_EQ(toml::find<std::string>(doc, "server", "host"), "localhost");
+    CHECK_EQ(toml::find(doc, "workers").as_array().size(), 2u);
+    CHECK_EQ(toml::find<std::string>(doc, "text"), "[still text]\nkey = ");
+    CHECK_EQ(toml::find_or<int>(doc, "missing", 7), 7);
+    CHECK(&toml::find(doc, "client") == &toml::find(doc, "client"));
+    CHECK_THROWS(toml::find(doc, "missing"), std::out_of_range);
+}
+
+TEST(parse_lazy_reports_errors_when_an_entry_is_read) {
+    TemporaryFile file("lazy_errors.toml",
+        "good = 1\n"
+        "bad = 1 2\n"
+        "[table]\n"
+        "key = 1\n"
+        "key = 2\n");
+    auto doc = toml::parse_lazy(file.path().string());
+    CHECK_EQ(toml::find<int>(doc, "good"), 1);
+    CHECK_THROWS(toml::find(doc, "bad"), toml::syntax_error);
+    CHECK_THROWS(toml::find(doc, "table"), toml::syntax_error);
+}
+
+TEST(parse_lazy_rejects_malformed_structure) {
+    TemporaryFile header("lazy_header.toml", "[table\nkey = 1\n");
+    CHECK_THROWS(toml::parse_lazy(header.path().string()), toml::syntax_error);
+    TemporaryFile separator("lazy_separator.toml", "key 1\n");
+    CHECK_THROWS(toml::parse_lazy(separator.path().string()), toml::syntax_error);
+    CHECK_THROWS(toml::parse_lazy((std::filesystem::temp_directory_path() / "polybuild-tests-missing.toml").string()), std::ios_base::failure);
+}
@@ -0,0 +1,89 @@
+#include "test.hpp"
+#include "toml.hpp"
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+static std::string error_of(const std::function<void()>& f) {
+    try {
+        f();
+    } catch (const std::exception& e) {
+        return e.what();
+    }
+    return {};
+}
+
+static bool contains(const std::string& str, const std::string& substr) {
+    return str.find(substr) != std::string::npos;
+}
+
+TEST(parse_without_regions_keeps_values_and_file_names) {
+    TemporaryFile file("regions.toml", "a = 1\n[tab]\nx = \"s\"\narr = [1, 2]");
+    toml::offset_arena arena;
+    auto data = toml::parse_without_regions(file.path().string(), arena);
+    CHECK_EQ(toml::find<int>(data, "a"), 1);
+    CHECK_EQ(toml::find<std::string>(data, "tab", "x"), "s");
+    CHECK_EQ(toml::find<int>(data, "tab", "arr", 1), 2);
+
+    auto location = toml::find(data, "tab", "x").location();
+    CHECK_EQ(location.file_name(), file.path().string());
+    CHECK(location.has_byte_offset());
+    CHECK_EQ(location.byte_offset(), 16u);
+    CHECK_EQ(location.line_str(), "");
+
+    // The arena can be reused, and the values of the first file stay valid
+    TemporaryFile other("regions_other.toml", "b = 2\n");
+    auto other_data = toml::parse_without_regions(other.path().string(), arena);
+    CHECK_EQ(toml::find<int>(other_data, "b"), 2);
+    CHECK_EQ(toml::find(data, "tab", "x").location().file_name(), file.path().string());
+}
+
+TEST(parse_without_regions_reports_byte_offsets) {
+    TemporaryFile file("regions.toml", "a = 1\n[tab]\nx = \"s\"\n");
+    toml::offset_arena arena;
+    auto data = toml::parse_without_regions(file.path().string(), arena);
+    const auto& tab = toml::find(data, "tab");
+
+    std::string missing = error_of([&]() { toml::find(tab, "nope"); });
+    CHECK(contains(missing, "key \"nope\" not found\n"));
+    CHECK(contains(missing, " --> " + file.path().string() + '\n'));
+    CHECK(contains(missing, "byte 6: in this table"));
+    CHECK(!contains(missing, " 1 | "));
+
+    std::string top_level = error_of([&]() { toml::find(data, "nope"); });
+    CHECK(contains(top_level, "not found in the top-level table"));
+    CHECK(contains(top_level, "byte 0: the top-level table starts here"));
+
+    std::string bad_cast = error_of([&]() { toml::find<int>(tab, "x"); });
+    CHECK(contains(bad_cast, "bad_cast to integer"));
+    CHECK(contains(bad_cast, "byte 16: the actual type is string"));
+    CHECK(!contains(bad_cast, " 1 | "));
+}
+
+TEST(parse_without_regions_reports_syntax_errors_with_lines) {
+    TemporaryFile file("regions_bad.toml", "a = 1\n[b]\nc = 1\n[b]\n");
+    toml::offset_arena arena;
+    std::string error = error_of([&]() { toml::parse_without_regions(file.path().string(), arena); });
+    CHECK(contains(error, "table (\"b\") already exists"));
+    CHECK(contains(error, " 2 | [b]"));
+    CHECK(contains(error, " 4 | [b]"));
+}
+
+TEST(parse_without_regions_values_outlive_the_arena) {
+    TemporaryFile file("regions.toml", "a = 1\n[tab]\nx = \"s\"\n");
+    toml::value data;
+    {
+        toml::offset_arena arena;
+        data = toml::parse_without_regions(file.path().string(), arena);
+    }
+    toml::value copy = toml::find(data, "tab");
+    data = toml::value();
+    CHECK_EQ(copy.location().file_name(), file.path().string());
+    CHECK_EQ(copy.location().byte_offset(), 6u);
+    CHECK(contains(error_of([&]() { toml::find(copy, "nope"); }), "byte 6: in this table"));
+
+    // Without an arena, the values keep one of their own
+    auto own = toml::parse_without_regions(file.path().string());
+    CHECK_EQ(toml::find<std::string>(own, "tab", "x"), "s");
+    CHECK_EQ(toml::find(own, "tab", "x").location().byte_offset(), 16u);
+}
@@ -0,0 +1,98 @@
+#include "test.hpp"
+#include "util.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+
+static std::vector<std::string> scan(std::string_view source, bool is_angled = false) {
+    std::vector<IncludeDirective> includes;
+    scan_includes(source, includes);
+
+    std::vector<std::string> ret;
+    for (const auto& include : includes) {
+        if (include.is_angled == is_angled) {
+            ret.push_back(include.name);
+        }
+    }
+    return ret;
+}
+
+using Names = std::vector<std::string>;
+
+TEST(scan_includes_finds_quoted_and_angled_directives) {
+    std::string_view source =
+        "#include \"a.hpp\"\n"
+        "#include <vector>\n"
+        "  #  include   \"b/c.hpp\"\n"
+        "#include\t<sys/stat.h>\n";
+    CHECK_EQ(scan(source), (Names {"a.hpp", "b/c.hpp"}));
+    CHECK_EQ(scan(source, true), (Names {"vector", "sys/stat.h"}));
+}
+
+TEST(scan_includes_handles_missing_trailing_newline_and_crlf) {
+    CHECK_EQ(scan("#include \"a.hpp\"\r\n#include \"b.hpp\""), (Names {"a.hpp", "b.hpp"}));
+    CHECK_EQ(scan("#include \"unterminated.hpp"), Names {});
+    CHECK_EQ(scan("#include \"\"\n#include"), Names {});
+}
+
+TEST(scan_includes_skips_comments) {
+    std::string_view source =
+        "// #include \"line_comment.hpp\"\n"
+        "/* #include \"block_comment.hpp\"\n"
+        "#include \"still_in_block_comment.hpp\" */\n"
+        "// a line comment that continues \\\n"
+        "#include \"continued_comment.hpp\"\n"
+        "/* leading */ #include \"after_block_comment.hpp\"\n"
+        "#include \"a.hpp\" // \"b.hpp\"\n";
+    CHECK_EQ(scan(source), (Names {"after_block_comment.hpp", "a.hpp"}));
+}
+
+TEST(scan_includes_skips_string_and_character_literals) {
+    std::string_view source =
+        "const char* s = \"\\\"\\n#include \\\"string.hpp\\\"\";\n"
+        "char c = '\"';\n"
+        "#include \"after_char.hpp\"\n"
+        "const char* raw = R\"delim(\n"
+        "#include \"raw_string.hpp\"\n"
+        ")delim\";\n"
+        "#include \"after_raw_string.hpp\"\n"
+        "int n = 1'000'000;\n"
+        "#include \"after_digit_separator.hpp\"\n";
+    CHECK_EQ(scan(source), (Names {"after_char.hpp", "after_raw_string.hpp", "after_digit_separator.hpp"}));
+}
+
+TEST(scan_includes_requires_directives_at_line_start) {
+    std::string_view source =
+        "int x; #include \"not_a_directive.hpp\"\n"
+        "#define INCLUDE #include \"in_a_macro.hpp\"\n"
+        "#include_next <next.h>\n"
+        "#includes \"misspelled.hpp\"\n"
+        "#pragma once\n";
+    CHECK_EQ(scan(source), Names {});
+    CHECK_EQ(scan(source, true), Names {});
+}
+
+TEST(scan_includes_follows_line_continuations) {
+    std::string_view source =
+        "#\\\n"
+        "include \"continued_hash.hpp\"\n"
+        "#include \\\r\n"
+        "  \"continued_crlf.hpp\"\n";
+    CHECK_EQ(scan(source), (Names {"continued_hash.hpp", "continued_crlf.hpp"}));
+}
+
+// Long stretches of ordinary code are skipped 16 bytes at a time, so every special character must be found wherever it falls in a block
+TEST(scan_includes_finds_special_characters_anywhere_in_long_lines) {
+    for (size_t padding = 0; padding < 40; ++padding) {
+        std::string code(padding, 'x');
+        std::string source =
+            code + "/* #include \"in_comment.hpp\" */ " + code + "\"#include <in_string.h>\" " + code + "\n" +
+            "#include \"a.hpp\"\n" +
+            code + "// #include \"in_line_comment.hpp\"\n" +
+            code + "'\"' " + code + "\n" +
+            "#include <b.h>\n" +
+            code;
+        CHECK_EQ(scan(source), Names {"a.hpp"});
+        CHECK_EQ(scan(source, true), Names {"b.h"});
+    }
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stddef.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A minimal test harness
+// TEST defines a test case that registers itself with the runner in main.cpp, and the CHECK macros report a failure without stopping the test
+
+struct TestCase {
+    const char* name;
+    void (*run)();
+};
+
+inline std::vector<TestCase>& test_cases() {
+    static std::vector<TestCase> ret;
+    return ret;
+}
+
+inline unsigned int& failure_count() {
+    static unsigned int ret = 0;
+    return ret;
+}
+
+inline void report_failure(const char* file, int line, const std::string& message) {
+    std::cerr << file << ':' << line << ": " << message << std::endl;
+    ++failure_count();
+}
+
+struct TestRegistration {
+    TestRegistration(const char* name, void (*run)()) {
+        test_cases().push_back({name, run});
+    }
+};
+
+#define TEST(name)                                                             \
+    static void test_##name();                                                 \
+    static const TestRegistration test_registration_##name(#name, test_##name); \
+    static void test_##name()
+
+#define CHECK(expr)                                                    \
+    do {                                                               \
+        if (!(expr)) {                                                 \
+            report_failure(__FILE__, __LINE__, "CHECK(" #expr ") failed"); \
+        }                                                              \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                          \
+    do {                                                                        \
+        if (!((a) == (b))) {                                                    \
+            report_failure(__FILE__, __LINE__, "CHECK_EQ(" #a ", " #b ") failed"); \
+        }                                                                       \
+    } while (0)
+
+#define CHECK_THROWS(expr, exception)                                                      \
+    do {                                                                                   \
+        bool thrown = false;                                                               \
+        try {                                                                              \
+            (void) (expr);                                                                 \
+        } catch (const exception&) {                                                       \
+            thrown = true;                                                                 \
+        }                                                                                  \
+        if (!thrown) {                                                                     \
+            report_failure(__FILE__, __LINE__, "CHECK_THROWS(" #expr ", " #exception ") failed"); \
+        }                                                                                  \
+    } while (0)
+
+// A file in the system's temporary directory that is deleted when it goes out of scope
+class TemporaryFile {
+public:
+    TemporaryFile(const std::string& name, std::string_view contents):
+        path_(std::filesystem::temp_directory_path() / ("polybuild-tests-" + name)) {
+        std::ofstream(path_, std::ios::binary) << contents;
+    }
+    TemporaryFile(const TemporaryFile&) = delete;
+    TemporaryFile& operator=(const TemporaryFile&) = delete;
+    ~TemporaryFile() {
+        std::error_code ec;
+        std::filesystem::remove(path_, ec);
+    }
+
+    const std::filesystem::path& path() const {
+        return path_;
+    }
+
+private:
+    std::filesystem::path path_;
+};
+
+// Measures how much memory something allocates at its peak
+// The operator new and delete in main.cpp only count allocations while an AllocationCounter exists, and only one may exist at a time
+class AllocationCounter {
+public:
+    AllocationCounter();
+    AllocationCounter(const AllocationCounter&) = delete;
+    AllocationCounter& operator=(const AllocationCounter&) = delete;
+    ~AllocationCounter();
+
+    // Returns the most bytes that were allocated at once since the counter was created
+    size_t peak_bytes() const;
+};
@@ -0,0 +1,86 @@
+#include "test.hpp"
+#include "toml.hpp"
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static toml::integer integer_of(const std::string& digits, int base = 10) {
+    toml::integer ret = -1;
+    if (!toml::detail::read_integer(digits.data(), digits.data() + digits.size(), base, ret)) {
+        throw std::out_of_range(digits);
+    }
+    return ret;
+}
+
+static toml::floating floating_of(const std::string& digits) {
+    toml::floating ret = -1.;
+    if (!toml::detail::read_floating(digits.data(), digits.data() + digits.size(), ret)) {
+        throw std::out_of_range(digits);
+    }
+    return ret;
+}
+
+static toml::value parse(const std::string& document) {
+    std::istringstream ss(document);
+    return toml::parse(ss);
+}
+
+TEST(read_integer_reads_every_base) {
+    CHECK_EQ(integer_of("0"), 0);
+    CHECK_EQ(integer_of("+42"), 42);
+    CHECK_EQ(integer_of("-17"), -17);
+    CHECK_EQ(integer_of("1_000_000"), 1000000);
+    CHECK_EQ(integer_of("1010", 2), 10);
+    CHECK_EQ(integer_of("0755", 8), 493);
+    CHECK_EQ(integer_of("dead_BEEF", 16), 0xdeadbeef);
+    CHECK_EQ(integer_of("000000000000000000000000000000000000000042"), 42);
+}
+
+TEST(read_integer_rejects_values_out_of_range) {
+    CHECK_EQ(integer_of("9223372036854775807"), std::numeric_limits<toml::integer>::max());
+    CHECK_EQ(integer_of("-9223372036854775808"), std::numeric_limits<toml::integer>::min());
+    CHECK_THROWS(integer_of("9223372036854775808"), std::out_of_range);
+    CHECK_THROWS(integer_of("-9223372036854775809"), std::out_of_range);
+    CHECK_EQ(integer_of("7fffffffffffffff", 16), std::numeric_limits<toml::integer>::max());
+    CHECK_THROWS(integer_of("8000000000000000", 16), std::out_of_range);
+    CHECK_THROWS(integer_of(std::string(64, '1'), 2), std::out_of_range);
+}
+
+TEST(read_floating_reads_decimal_and_exponent_forms) {
+    CHECK_EQ(floating_of("3.14159"), 3.14159);
+    CHECK_EQ(floating_of("+1.5"), 1.5);
+    CHECK_EQ(floating_of("-0.5"), -0.5);
+    CHECK_EQ(floating_of("1_000.25"), 1000.25);
+    CHECK_EQ(floating_of("6.02e+23"), 6.02e23);
+    CHECK_EQ(floating_of("1E-7"), 1e-7);
+    CHECK(std::signbit(floating_of("-0.0")));
+    CHECK_EQ(floating_of("0.1000000000000000055511151231257827021181583404541015625000000000"), 0.1);
+    CHECK_THROWS(floating_of("1e400"), std::out_of_range);
+}
+
+TEST(toml_numbers_parse_through_the_parser) {
+    auto data = parse(
+        "ints = [1, -2, +3, 4_000, 0xff, 0o17, 0b101]\n"
+        "floats = [1.0, -2.5e3, 1e-2, inf, -inf]\n"
+        "nan = nan\n");
+    CHECK_EQ(toml::find<std::vector<toml::integer>>(data, "ints"), (std::vector<toml::integer> {1, -2, 3, 4000, 255, 15, 5}));
+    auto floats = toml::find<std::vector<toml::floating>>(data, "floats");
+    CHECK_EQ(floats.size(), 5u);
+    CHECK_EQ(floats[0], 1.0);
+    CHECK_EQ(floats[1], -2500.0);
+    CHECK_EQ(floats[2], 0.01);
+    CHECK(std::isinf(floats[3]) && floats[3] > 0);
+    CHECK(std::isinf(floats[4]) && floats[4] < 0);
+    CHECK(std::isnan(toml::find<toml::floating>(data, "nan")));
+}
+
+TEST(toml_numbers_out_of_range_are_syntax_errors) {
+    CHECK_THROWS(parse("a = 9223372036854775808\n"), toml::syntax_error);
+    CHECK_THROWS(parse("a = 0x1_0000_0000_0000_0000\n"), toml::syntax_error);
+    CHECK_THROWS(parse("a = 1e999\n"), toml::syntax_error);
+    CHECK_THROWS(parse("a = 1__0\n"), toml::syntax_error);
+    CHECK_THROWS(parse("a = 012\n"), toml::syntax_error);
+}
@@ -0,0 +1,64 @@
+#include "test.hpp"
+#include "util.hpp"
+#include <chrono>
+#include <filesystem>
+#include <ostream>
+#include <string>
+#include <system_error>
+
+static bool write_streamed(const std::filesystem::path& path, const std::string& contents) {
+    return write_file_if_changed(path, [&contents](std::ostream& os) {
+        // Small pieces, so that the stream buffer fills up in the middle of them
+        for (size_t i = 0; i < contents.size(); i += 1000) {
+            os << contents.substr(i, 1000);
+        }
+    });
+}
+
+static bool has_temporary_files(const std::filesystem::path& path) {
+    for (const auto& entry : std::filesystem::directory_iterator(path.parent_path())) {
+        std::string name = entry.path().filename().string();
+        if (name.rfind(path.filename().string() + '.', 0) == 0 && name.size() > 4 && name.compare(name.size() - 4, 4, ".tmp") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+TEST(write_file_if_changed_streams_only_changes) {
+    TemporaryFile file("streamed.mk", "");
+    std::filesystem::remove(file.path());
+
+    std::string contents;
+    for (size_t i = 0; contents.size() < 200000; ++i) {
+        contents += "obj/s" + std::to_string(i) + ".o: src/s" + std::to_string(i) + ".cpp\n";
+    }
+    CHECK(write_streamed(file.path(), contents));
+    CHECK_EQ(read_file(file.path()), contents);
+    CHECK(!write_streamed(file.path(), contents));
+
+    // Past the first buffer, so that the part that matched has to be copied
+    std::string changed = contents;
+    changed[150000] = '#';
+    CHECK(write_streamed(file.path(), changed));
+    CHECK_EQ(read_file(file.path()), changed);
+
+    CHECK(write_streamed(file.path(), changed + "more\n"));
+    CHECK_EQ(read_file(file.path()), changed + "more\n");
+    CHECK(write_streamed(file.path(), changed.substr(0, 100000)));
+    CHECK_EQ(read_file(file.path()), changed.substr(0, 100000));
+    CHECK(write_streamed(file.path(), ""));
+    CHECK_EQ(read_file(file.path()), "");
+    CHECK(!write_streamed(file.path(), ""));
+
+    CHECK(!has_temporary_files(file.path()));
+}
+
+TEST(write_file_if_changed_leaves_unchanged_files_alone) {
+    TemporaryFile file("unchanged.mk", "all:\n");
+    auto mtime = std::filesystem::last_write_time(file.path());
+    std::filesystem::last_write_time(file.path(), mtime - std::chrono::hours(1));
+    CHECK(!write_file_if_changed(file.path(), "all:\n"));
+    CHECK(!write_streamed(file.path(), "all:\n"));
+    CHECK(std::filesystem::last_write_time(file.path()) == mtime - std::chrono::hours(1));
+}
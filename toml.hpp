@@ -33,6 +33,9 @@
 #include "toml/literal.hpp"
 #include "toml/serializer.hpp"
 #include "toml/get.hpp"
+#include "toml/lazy.hpp"
+#include "toml/binding.hpp"
 #include "toml/macros.hpp"
+#include "toml/events.hpp"
 
 #endif// TOML_FOR_MODERN_CPP
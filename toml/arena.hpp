@@ -0,0 +1,191 @@
+// Distributed under the MIT License.
+#ifndef TOML11_ARENA_HPP
+#define TOML11_ARENA_HPP
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "region.hpp"
+#include "storage.hpp"
+#include "value.hpp"
+
+namespace toml
+{
+namespace detail
+{
+
+// value_arena hands out the memory for the tables and arrays of one document,
+// and for the storages that hold them, so that parsing a document with many
+// small tables does not allocate each of them separately. Memory is never
+// reused and is freed all at once when the last table or array is gone.
+//
+// While the document is parsed, only the parser allocates from the arena.
+// Afterwards, the tables and arrays can be modified from any thread, so the
+// arena takes a lock from then on.
+class value_arena
+{
+  public:
+
+    value_arena() = default;
+    value_arena(const value_arena&) = delete;
+    value_arena& operator=(const value_arena&) = delete;
+    ~value_arena() = default;
+
+    void* allocate(std::size_t size, std::size_t alignment)
+    {
+        if(!this->is_shared_)
+        {
+            return this->arena_.allocate(size, alignment);
+        }
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        return this->arena_.allocate(size, alignment);
+    }
+
+    // called by the parser before it returns the document.
+    void share() noexcept {this->is_shared_ = true;}
+
+  private:
+
+    region_arena arena_;
+    std::mutex   mutex_;
+    bool         is_shared_ = false;
+};
+
+// the arena of the document that this thread is parsing, if any.
+inline std::shared_ptr<value_arena>& current_value_arena() noexcept
+{
+    static thread_local std::shared_ptr<value_arena> arena;
+    return arena;
+}
+
+} // detail
+
+// arena_allocator allocates from the arena of the document that is being
+// parsed when it is made, and from the heap otherwise. Use it through
+// arena_unordered_map and arena_vector, e.g.
+//
+// const auto data = toml::parse<toml::discard_comments,
+//         toml::arena_unordered_map, toml::arena_vector>(fname);
+//
+// Copies of the tables and arrays are made with a new allocator, so a copy
+// made after parsing is on the heap and does not keep the arena alive. A table
+// or an array moved out of a document keeps its allocator, and with it the
+// arena. The memory of an arena is only freed once nothing allocated from it
+// is left, so modifying a parsed document over and over keeps growing it.
+template<typename T>
+struct arena_allocator
+{
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap            = std::true_type;
+
+    arena_allocator() noexcept: arena_(detail::current_value_arena()) {}
+    template<typename U>
+    arena_allocator(const arena_allocator<U>& other) noexcept
+        : arena_(other.arena_)
+    {}
+
+    // large blocks, like the buffers of long arrays that are reallocated as
+    // they grow, come from the heap so that their memory can be reused.
+    T* allocate(std::size_t n)
+    {
+        if(this->arena_ && n * sizeof(T) <= max_arena_size)
+        {
+            return static_cast<T*>(this->arena_->allocate(n * sizeof(T), alignof(T)));
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+        if(!this->arena_ || n * sizeof(T) > max_arena_size)
+        {
+            ::operator delete(p);
+        }
+    }
+
+    arena_allocator select_on_container_copy_construction() const
+    {
+        return arena_allocator();
+    }
+
+    template<typename U>
+    bool operator==(const arena_allocator<U>& other) const noexcept
+    {
+        return this->arena_ == other.arena_;
+    }
+    template<typename U>
+    bool operator!=(const arena_allocator<U>& other) const noexcept
+    {
+        return this->arena_ != other.arena_;
+    }
+
+  private:
+
+    template<typename U>
+    friend struct arena_allocator;
+
+    static constexpr std::size_t max_arena_size = 1024;
+
+    std::shared_ptr<detail::value_arena> arena_;
+};
+
+template<typename T>
+using arena_vector = std::vector<T, arena_allocator<T>>;
+
+template<typename Key, typename T>
+using arena_unordered_map = std::unordered_map<Key, T, std::hash<Key>,
+    std::equal_to<Key>, arena_allocator<std::pair<const Key, T>>>;
+
+// a toml::value whose tables and arrays are allocated from the arena of the
+// document they were parsed from. Strings and keys are std::string as usual,
+// and short ones are stored inline.
+using arena_value = basic_value<TOML11_DEFAULT_COMMENT_STRATEGY,
+                                arena_unordered_map, arena_vector>;
+
+namespace detail
+{
+
+template<typename Allocator>
+struct is_arena_allocator : std::false_type {};
+template<typename T>
+struct is_arena_allocator<arena_allocator<T>> : std::true_type {};
+
+// gives a parse of `Value` an arena of its own if its tables or arrays are
+// allocated with arena_allocator, and does nothing otherwise.
+template<typename Value, bool = is_arena_allocator<typename storage_allocator<
+        typename Value::table_type>::type>::value ||
+    is_arena_allocator<typename storage_allocator<
+        typename Value::array_type>::type>::value>
+struct value_arena_scope
+{
+    value_arena_scope() {}
+};
+
+template<typename Value>
+struct value_arena_scope<Value, true>
+{
+    value_arena_scope(): previous_(std::move(current_value_arena()))
+    {
+        current_value_arena() = std::make_shared<value_arena>();
+    }
+    value_arena_scope(const value_arena_scope&) = delete;
+    value_arena_scope& operator=(const value_arena_scope&) = delete;
+    ~value_arena_scope()
+    {
+        current_value_arena()->share();
+        current_value_arena() = std::move(this->previous_);
+    }
+
+  private:
+
+    std::shared_ptr<value_arena> previous_;
+};
+
+} // detail
+} // toml
+#endif// TOML11_ARENA_HPP
@@ -0,0 +1,176 @@
+// Distributed under the MIT License.
+#ifndef TOML11_BINDING_HPP
+#define TOML11_BINDING_HPP
+#include <memory>
+
+#include "get.hpp"
+#include "lazy.hpp"
+
+#if TOML11_CPLUSPLUS_STANDARD_VERSION >= 201703L
+#if __has_include(<optional>)
+#define TOML11_HAS_STD_OPTIONAL
+#include <optional>
+#endif
+#endif
+
+// Declarative decoding of tables into structs, to implement toml::from<T> and
+// toml::into<T> without a toml::find per member.
+//
+// ```cpp
+// struct server
+// {
+//     std::string              host = "localhost";
+//     std::uint16_t            port = 8080;
+//     std::vector<std::string> routes;
+//     std::optional<double>    timeout; // needs C++17
+// };
+// namespace toml
+// {
+// template<>
+// struct from<server>
+// {
+//     static server from_toml(const value& v)
+//     {
+//         server s;
+//         toml::decode_fields(v, s,
+//             toml::required_field("host", &server::host),
+//             toml::field("port",    &server::port),
+//             toml::field("routes",  &server::routes),
+//             toml::field("timeout", &server::timeout));
+//         return s;
+//     }
+// };
+// } // toml
+// ```
+//
+// Each field is looked up once and converted with toml::get straight into the
+// member. A missing `field` leaves the member as it is, so the default member
+// initializers are the defaults, and a missing `required_field` throws like
+// toml::find. Fields are decoded in the order they are listed, so when two keys
+// are bound to one member (e.g. an old name and a new one), the later wins.
+// A std::optional member is set only if the key exists.
+//
+// decode_fields also takes a lazy_document, in which case only the entries
+// bound to the fields are parsed.
+
+namespace toml
+{
+
+template<typename T, typename M>
+struct field_binding
+{
+    const char* key;
+    M T::*      member;
+    bool        required;
+};
+
+template<typename T, typename M>
+field_binding<T, M> field(const char* key, M T::* member)
+{
+    return field_binding<T, M>{key, member, false};
+}
+
+template<typename T, typename M>
+field_binding<T, M> required_field(const char* key, M T::* member)
+{
+    return field_binding<T, M>{key, member, true};
+}
+
+namespace detail
+{
+
+// returns nullptr if there is no such key.
+template<typename C,
+         template<typename ...> class M, template<typename ...> class V>
+basic_value<C, M, V> const*
+find_field(const basic_value<C, M, V>& v, const key& ky)
+{
+    const auto& tab = v.as_table();
+    const auto found = tab.find(ky);
+    if(found == tab.end())
+    {
+        return nullptr;
+    }
+    return std::addressof(found->second);
+}
+
+template<typename C,
+         template<typename ...> class M, template<typename ...> class V>
+basic_value<C, M, V> const*
+find_field(basic_lazy_document<C, M, V>& doc, const key& ky)
+{
+    if(!doc.contains(ky))
+    {
+        return nullptr;
+    }
+    return std::addressof(doc.at(ky));
+}
+
+template<typename T, typename Value>
+void decode_member(T& member, const Value& v)
+{
+    member = ::toml::get<T>(v);
+}
+
+#ifdef TOML11_HAS_STD_OPTIONAL
+template<typename T, typename Value>
+void decode_member(std::optional<T>& member, const Value& v)
+{
+    member = ::toml::get<T>(v);
+}
+#endif
+
+template<typename Source, typename T, typename M>
+void decode_field(Source& src, T& obj, const field_binding<T, M>& binding)
+{
+    if(binding.required)
+    {
+        // throws an error that points the table if not found
+        decode_member(obj.*(binding.member), ::toml::find(src, binding.key));
+    }
+    else if(const auto found = find_field(src, binding.key))
+    {
+        decode_member(obj.*(binding.member), *found);
+    }
+}
+
+template<typename Table, typename T>
+void encode_member(Table& tab, const key& ky, const T& member)
+{
+    tab[ky] = typename Table::mapped_type(member);
+}
+
+#ifdef TOML11_HAS_STD_OPTIONAL
+template<typename Table, typename T>
+void encode_member(Table& tab, const key& ky, const std::optional<T>& member)
+{
+    if(member)
+    {
+        tab[ky] = typename Table::mapped_type(*member);
+    }
+}
+#endif
+
+} // detail
+
+// `src` is a table or a lazy_document.
+template<typename Source, typename T, typename ... Ms>
+T& decode_fields(Source& src, T& obj, const field_binding<T, Ms>& ... fields)
+{
+    using swallow = int[];
+    (void)swallow{0, (detail::decode_field(src, obj, fields), 0)...};
+    return obj;
+}
+
+template<typename Value = ::toml::value, typename T, typename ... Ms>
+Value encode_fields(const T& obj, const field_binding<T, Ms>& ... fields)
+{
+    typename Value::table_type tab;
+    using swallow = int[];
+    (void)swallow{0, (detail::encode_member(
+                tab, fields.key, obj.*(fields.member)), 0)...};
+    return Value(std::move(tab));
+}
+
+} // toml
+#endif// TOML11_BINDING_HPP
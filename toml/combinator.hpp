@@ -14,6 +14,7 @@
 
 #include "region.hpp"
 #include "result.hpp"
+#include "scan.hpp"
 #include "traits.hpp"
 #include "utility.hpp"
 
@@ -301,6 +302,36 @@ struct repeat<T, unlimited>
     }
 };
 
+// the same as repeat<T, at_least<N>>, but it skips each run of characters in
+// `CharClass` at once and calls T only for the character after the run (e.g.
+// an escape sequence or a multi-byte utf-8 character). every character in
+// CharClass should be accepted by T by itself.
+template<typename T, typename CharClass, std::size_t N>
+struct scan_repeat
+{
+    static result<region, none_t>
+    invoke(location& loc)
+    {
+        const auto first = loc.iter();
+        std::size_t matched = 0;
+        while(true)
+        {
+            const auto run_last = scan_while<CharClass>(loc.iter(), loc.end());
+            matched += static_cast<std::size_t>(run_last - loc.iter());
+            loc.advance(run_last - loc.iter());
+
+            if(!T::invoke(loc)) {break;}
+            ++matched;
+        }
+        if(matched < N)
+        {
+            loc.reset(first);
+            return none();
+        }
+        return ok(region(loc, first, loc.iter()));
+    }
+};
+
 } // detail
 } // toml
 #endif// TOML11_COMBINATOR_HPP
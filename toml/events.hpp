@@ -0,0 +1,470 @@
+// Distributed under the MIT License.
+#ifndef TOML11_EVENTS_HPP
+#define TOML11_EVENTS_HPP
+#include <fstream>
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "parser.hpp"
+#include "source_location.hpp"
+
+// An event-driven interface to the parser. Instead of building a basic_value
+// for the whole document, `parse_events` walks through the document and calls
+// the member functions of a handler for each component it finds, so that the
+// caller can pick up only the keys it needs or feed the values into its own
+// data structures.
+//
+// ```cpp
+// struct find_name : toml::event_handler
+// {
+//     std::vector<toml::key> table;
+//     std::string name;
+//
+//     bool on_table_header(const std::vector<toml::key>& keys,
+//                          const toml::source_location&)
+//     {
+//         table = keys;
+//         return true;
+//     }
+//     bool on_key(const std::vector<toml::key>& keys,
+//                 const toml::source_location&)
+//     {
+//         found = table == std::vector<toml::key>{"package"} &&
+//                 keys == std::vector<toml::key>{"name"};
+//         return true;
+//     }
+//     bool on_value(const toml::value& v)
+//     {
+//         if(!found) {return true;}
+//         name = v.as_string();
+//         return false; // no need to read the rest.
+//     }
+//     bool found = false;
+// };
+// ```
+//
+// Scalars (strings, numbers, booleans and datetimes) are passed to `on_value`
+// as a toml::value. Arrays and inline tables are not; instead, their elements
+// are reported between `on_array_begin`/`on_array_end` and
+// `on_inline_table_begin`/`on_inline_table_end`. Keys are reported as written,
+// i.e. relative to the last table header or the enclosing inline table.
+//
+// Every member function returns true to continue or false to stop parsing.
+// Syntax errors are thrown as toml::syntax_error, as `toml::parse` does.
+// Semantic errors that need the whole document, like a key defined twice, are
+// not detected.
+
+namespace toml
+{
+
+// A handler that ignores everything. Derive from it and hide the functions
+// that are needed.
+struct event_handler
+{
+    bool on_table_header(const std::vector<key>&, const source_location&)
+    {
+        return true;
+    }
+    bool on_array_table_header(const std::vector<key>&, const source_location&)
+    {
+        return true;
+    }
+    bool on_key(const std::vector<key>&, const source_location&)
+    {
+        return true;
+    }
+    bool on_value(const value&)
+    {
+        return true;
+    }
+    bool on_array_begin(const source_location&)
+    {
+        return true;
+    }
+    bool on_array_end(const source_location&)
+    {
+        return true;
+    }
+    bool on_inline_table_begin(const source_location&)
+    {
+        return true;
+    }
+    bool on_inline_table_end(const source_location&)
+    {
+        return true;
+    }
+};
+
+namespace detail
+{
+
+// The scalars that parse_events reports are dropped as soon as `on_value`
+// returns. Allocating their regions from the arena of the source would keep
+// every one of them until the end, so they share one region instead, which is
+// reused unless the handler kept a copy of the last value.
+struct event_region_store final : public region_store
+{
+    explicit event_region_store(const location::source_ptr& source)
+        : source_(source.get())
+    {
+        this->source_->set_store(this);
+    }
+    event_region_store(const event_region_store&) = delete;
+    event_region_store& operator=(const event_region_store&) = delete;
+    ~event_region_store() override
+    {
+        this->source_->set_store(nullptr);
+    }
+
+    std::shared_ptr<region_base> make(const region& reg) override
+    {
+        if(this->last_.use_count() == 1)
+        {
+            *this->last_ = reg;
+        }
+        else
+        {
+            this->last_ = std::make_shared<region>(reg);
+        }
+        return this->last_;
+    }
+
+  private:
+
+    const source_buffer*    source_;
+    std::shared_ptr<region> last_;
+};
+
+template<typename Handler>
+bool parse_value_events(location& loc, Handler& handler, const std::size_t n_rec);
+
+template<typename Handler>
+bool parse_array_events(location& loc, Handler& handler, const std::size_t n_rec)
+{
+    if(n_rec > TOML11_VALUE_RECURSION_LIMIT)
+    {
+        throw syntax_error(std::string("toml::parse_array: recursion limit ("
+                TOML11_STRINGIZE(TOML11_VALUE_RECURSION_LIMIT) ") exceeded"),
+                source_location(loc));
+    }
+    assert(loc.iter() != loc.end() && *loc.iter() == '[');
+
+    const auto array_start_loc = loc;
+    if(!handler.on_array_begin(source_location(loc))) {return false;}
+    loc.advance();
+
+    using lex_ws_comment_newline = repeat<
+        either<lex_wschar, lex_newline, lex_comment>, unlimited>;
+
+    while(loc.iter() != loc.end())
+    {
+        lex_ws_comment_newline::invoke(loc); // skip
+
+        if(loc.iter() != loc.end() && *loc.iter() == ']')
+        {
+            const auto end_loc = loc;
+            loc.advance(); // skip ']'
+            return handler.on_array_end(source_location(end_loc));
+        }
+
+        if(!guess_value_type(loc))
+        {
+            throw syntax_error(format_underline("toml::parse_array: "
+                "value having invalid format appeared in an array", {
+                    {source_location(array_start_loc), "array starts here"},
+                    {source_location(loc), "it is not a valid value."}
+                }), source_location(loc));
+        }
+        if(!parse_value_events(loc, handler, n_rec+1)) {return false;}
+
+        using lex_array_separator = sequence<maybe<lex_ws_comment_newline>, character<','>>;
+        const auto sp = lex_array_separator::invoke(loc);
+        if(!sp)
+        {
+            lex_ws_comment_newline::invoke(loc);
+            if(loc.iter() != loc.end() && *loc.iter() == ']')
+            {
+                const auto end_loc = loc;
+                loc.advance(); // skip ']'
+                return handler.on_array_end(source_location(end_loc));
+            }
+            throw syntax_error(format_underline("toml::parse_array:"
+                " missing array separator `,` after a value", {
+                    {source_location(array_start_loc), "array starts here"},
+                    {source_location(loc),             "should be `,`"}
+                }), source_location(loc));
+        }
+    }
+    throw syntax_error(format_underline("toml::parse_array: "
+            "array did not closed by `]`",
+            {{source_location(array_start_loc), "should be closed"}}),
+            source_location(array_start_loc));
+}
+
+// parses `key = value` and reports the key and the value.
+template<typename Handler>
+bool parse_key_value_pair_events(location& loc, Handler& handler,
+                                 const std::size_t n_rec)
+{
+    const auto first = loc.iter();
+    const auto key_reg = parse_key(loc);
+    if(!key_reg)
+    {
+        std::string msg = key_reg.unwrap_err();
+        if(lex_keyval_sep::invoke(loc))
+        {
+            loc.reset(first);
+            msg = format_underline("toml::parse_key_value_pair: "
+                "empty key is not allowed.",
+                {{source_location(loc), "key expected before '='"}});
+        }
+        throw syntax_error(msg, source_location(loc));
+    }
+    if(!lex_keyval_sep::invoke(loc))
+    {
+        throw syntax_error(format_underline("toml::parse_key_value_pair: "
+            "missing key-value separator `=`",
+            {{source_location(loc), "should be `=`"}}), source_location(loc));
+    }
+    if(!handler.on_key(key_reg.unwrap().first,
+                       source_location(key_reg.unwrap().second)))
+    {
+        return false;
+    }
+
+    const auto after_kvsp = loc.iter();
+    const auto type = guess_value_type(loc);
+    if(!type)
+    {
+        std::string msg = type.unwrap_err();
+        if(sequence<maybe<lex_ws>, maybe<lex_comment>, lex_newline>::invoke(loc))
+        {
+            loc.reset(after_kvsp);
+            msg = format_underline("toml::parse_key_value_pair: "
+                    "missing value after key-value separator '='",
+                    {{source_location(loc), "expected value, but got nothing"}});
+        }
+        throw syntax_error(msg, source_location(loc));
+    }
+    return parse_value_events(loc, handler, n_rec);
+}
+
+template<typename Handler>
+bool parse_inline_table_events(location& loc, Handler& handler,
+                               const std::size_t n_rec)
+{
+    if(n_rec > TOML11_VALUE_RECURSION_LIMIT)
+    {
+        throw syntax_error(std::string("toml::parse_inline_table: recursion limit ("
+                TOML11_STRINGIZE(TOML11_VALUE_RECURSION_LIMIT) ") exceeded"),
+                source_location(loc));
+    }
+    assert(loc.iter() != loc.end() && *loc.iter() == '{');
+
+    const auto table_start_loc = loc;
+    if(!handler.on_inline_table_begin(source_location(loc))) {return false;}
+    loc.advance();
+
+    // check if the inline table is an empty table = { }
+    maybe<lex_ws>::invoke(loc);
+    if(loc.iter() != loc.end() && *loc.iter() == '}')
+    {
+        const auto end_loc = loc;
+        loc.advance(); // skip `}`
+        return handler.on_inline_table_end(source_location(end_loc));
+    }
+
+    while(loc.iter() != loc.end())
+    {
+        if(!parse_key_value_pair_events(loc, handler, n_rec+1)) {return false;}
+
+        using lex_table_separator = sequence<maybe<lex_ws>, character<','>>;
+        if(!lex_table_separator::invoke(loc))
+        {
+            maybe<lex_ws>::invoke(loc);
+
+            if(loc.iter() == loc.end())
+            {
+                throw syntax_error(format_underline(
+                    "toml::parse_inline_table: missing table separator `}` ",
+                    {{source_location(loc), "should be `}`"}}),
+                    source_location(loc));
+            }
+            else if(*loc.iter() == '}')
+            {
+                const auto end_loc = loc;
+                loc.advance(); // skip `}`
+                return handler.on_inline_table_end(source_location(end_loc));
+            }
+            else if(*loc.iter() == '#' || *loc.iter() == '\r' || *loc.iter() == '\n')
+            {
+                throw syntax_error(format_underline(
+                    "toml::parse_inline_table: missing curly brace `}`",
+                    {{source_location(loc), "should be `}`"}}),
+                    source_location(loc));
+            }
+            else
+            {
+                throw syntax_error(format_underline(
+                    "toml::parse_inline_table: missing table separator `,` ",
+                    {{source_location(loc), "should be `,`"}}),
+                    source_location(loc));
+            }
+        }
+        maybe<lex_ws>::invoke(loc);
+        if(loc.iter() != loc.end() && *loc.iter() == '}')
+        {
+            throw syntax_error(format_underline(
+                "toml::parse_inline_table: trailing comma is not allowed in"
+                " an inline table",
+                {{source_location(loc), "should be `}`"}}),
+                source_location(loc));
+        }
+    }
+    throw syntax_error(format_underline("toml::parse_inline_table: "
+            "inline table did not closed by `}`",
+            {{source_location(table_start_loc), "should be closed"}}),
+            source_location(table_start_loc));
+}
+
+template<typename Handler>
+bool parse_value_events(location& loc, Handler& handler, const std::size_t n_rec)
+{
+    const auto first = loc.iter();
+    if(first != loc.end() && *first == '[')
+    {
+        return parse_array_events(loc, handler, n_rec);
+    }
+    if(first != loc.end() && *first == '{')
+    {
+        return parse_inline_table_events(loc, handler, n_rec);
+    }
+    auto val = parse_value<::toml::value>(loc, n_rec);
+    if(!val)
+    {
+        throw syntax_error(val.unwrap_err(), source_location(loc));
+    }
+    return handler.on_value(val.unwrap());
+}
+
+// the source of `loc` must end with a newline, like detail::parse(location).
+template<typename Handler>
+bool parse_events(location loc, Handler& handler)
+{
+    // skip BOM if exists. see detail::parse(location).
+    if(loc.source()->size() >= 3)
+    {
+        std::array<unsigned char, 3> BOM;
+        std::memcpy(BOM.data(), loc.source()->data(), 3);
+        if(BOM[0] == 0xEF && BOM[1] == 0xBB && BOM[2] == 0xBF)
+        {
+            loc.advance(3); // BOM found. skip.
+        }
+    }
+
+    const event_region_store store(loc.source());
+
+    // the same as parse_ml_table, but for the whole file.
+    using skip_line = repeat<
+        sequence<maybe<lex_ws>, maybe<lex_comment>, lex_newline>, at_least<1>>;
+    skip_line::invoke(loc);
+
+    while(loc.iter() != loc.end())
+    {
+        lex_ws::invoke(loc);
+        if(is_array_table_key_head(loc))
+        {
+            if(const auto tabkey = parse_array_table_key(loc))
+            {
+                if(!handler.on_array_table_header(tabkey.unwrap().first,
+                        source_location(tabkey.unwrap().second)))
+                {
+                    return false;
+                }
+                skip_line::invoke(loc);
+                continue;
+            }
+        }
+        if(is_table_key_head(loc))
+        {
+            if(const auto tabkey = parse_table_key(loc))
+            {
+                if(!handler.on_table_header(tabkey.unwrap().first,
+                        source_location(tabkey.unwrap().second)))
+                {
+                    return false;
+                }
+                skip_line::invoke(loc);
+                continue;
+            }
+        }
+        if(!parse_key_value_pair_events(loc, handler, 0)) {return false;}
+
+        lex_ws::invoke(loc);
+        lex_comment::invoke(loc);
+        const auto newline = skip_line::invoke(loc);
+        if(!newline && loc.iter() != loc.end())
+        {
+            lex_ws::invoke(loc); // skip whitespace
+            throw syntax_error(format_underline("toml::parse_table: "
+                "invalid line format", {{source_location(loc), concat_to_string(
+                "expected newline, but got '", show_char(*loc.iter()), "'.")}}),
+                source_location(loc));
+        }
+    }
+    return true;
+}
+
+} // detail
+
+// Parses a document from a stream and reports its contents to `handler`.
+// Returns false if the handler stopped parsing, true otherwise.
+template<typename Handler>
+bool parse_events(std::istream& is, Handler& handler,
+                  std::string fname = "unknown file")
+{
+    const auto beg = is.tellg();
+    is.seekg(0, std::ios::end);
+    const auto end = is.tellg();
+    const auto fsize = end - beg;
+    is.seekg(beg);
+
+    // read whole file as a sequence of char
+    assert(fsize >= 0);
+    std::vector<char> letters(static_cast<std::size_t>(fsize));
+    is.read(letters.data(), fsize);
+
+    // append LF. see detail::parse(std::vector<char>&, fname).
+    if(!letters.empty() && letters.back() != '\n' && letters.back() != '\r')
+    {
+        letters.push_back('\n');
+    }
+    return detail::parse_events(
+            detail::location(std::move(fname), std::move(letters)), handler);
+}
+
+// Parses a file and reports its contents to `handler`. Where it is supported,
+// the file is mapped into memory instead of being read, so the memory used
+// does not grow with the size of the file.
+template<typename Handler>
+bool parse_events(std::string fname, Handler& handler)
+{
+#ifdef TOML11_HAS_MMAP
+    if(auto source = detail::map_file(fname))
+    {
+        return detail::parse_events(detail::location(std::move(source)), handler);
+    }
+#endif
+    std::ifstream ifs(fname, std::ios_base::binary);
+    if(!ifs.good())
+    {
+        throw std::ios_base::failure(
+                "toml::parse_events: Error opening file \"" + fname + "\"");
+    }
+    ifs.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    return parse_events(ifs, handler, std::move(fname));
+}
+
+} // toml
+#endif// TOML11_EVENTS_HPP
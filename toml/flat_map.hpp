@@ -0,0 +1,391 @@
+// Distributed under the MIT License.
+#ifndef TOML11_FLAT_MAP_HPP
+#define TOML11_FLAT_MAP_HPP
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace toml
+{
+
+// flat_map is a map-like container that keeps its elements in a vector sorted
+// by key. It can be used as the `Table` of basic_value, like
+//
+// using value = toml::basic_value<toml::discard_comments, toml::flat_map>;
+// const auto data = toml::parse<toml::discard_comments, toml::flat_map>(fname);
+//
+// Tables in a configuration file are usually small and are built once and read
+// many times, so a binary search through a contiguous array beats hashing and
+// chasing the nodes of a std::unordered_map. Iteration is in key order.
+//
+// Inserting a key in the middle of the table moves all the elements after it,
+// but keys that arrive in ascending order are appended in constant time.
+//
+// Unlike std::map, value_type is std::pair<Key, T> and not
+// std::pair<const Key, T> because the elements have to be movable. Do not
+// modify the keys through iterators.
+template<typename Key, typename T, typename Compare = std::less<Key>,
+         typename Allocator = std::allocator<std::pair<Key, T>>>
+class flat_map
+{
+  public:
+
+    using key_type               = Key;
+    using mapped_type            = T;
+    using value_type             = std::pair<Key, T>;
+    using key_compare            = Compare;
+    using allocator_type         = Allocator;
+    using container_type         = std::vector<value_type, Allocator>;
+    using size_type              = typename container_type::size_type;
+    using difference_type        = typename container_type::difference_type;
+    using reference              = value_type&;
+    using const_reference        = value_type const&;
+    using iterator               = typename container_type::iterator;
+    using const_iterator         = typename container_type::const_iterator;
+    using reverse_iterator       = typename container_type::reverse_iterator;
+    using const_reverse_iterator = typename container_type::const_reverse_iterator;
+
+    flat_map() = default;
+    ~flat_map() = default;
+    flat_map(flat_map const&) = default;
+    flat_map(flat_map &&)     = default;
+    flat_map& operator=(flat_map const&) = default;
+    flat_map& operator=(flat_map &&)     = default;
+
+    explicit flat_map(const key_compare& comp,
+                      const allocator_type& alloc = allocator_type())
+        : container_(alloc), comp_(comp)
+    {}
+    explicit flat_map(const allocator_type& alloc)
+        : container_(alloc), comp_()
+    {}
+
+    template<typename InputIterator>
+    flat_map(InputIterator first, InputIterator last,
+             const key_compare& comp = key_compare(),
+             const allocator_type& alloc = allocator_type())
+        : container_(alloc), comp_(comp)
+    {
+        this->insert(first, last);
+    }
+
+    flat_map(std::initializer_list<value_type> list,
+             const key_compare& comp = key_compare(),
+             const allocator_type& alloc = allocator_type())
+        : container_(alloc), comp_(comp)
+    {
+        this->insert(list.begin(), list.end());
+    }
+    flat_map& operator=(std::initializer_list<value_type> list)
+    {
+        this->container_.clear();
+        this->insert(list.begin(), list.end());
+        return *this;
+    }
+
+    // iterators ------------------------------------------------------------
+
+    iterator       begin()        noexcept {return container_.begin();}
+    iterator       end()          noexcept {return container_.end();}
+    const_iterator begin()  const noexcept {return container_.begin();}
+    const_iterator end()    const noexcept {return container_.end();}
+    const_iterator cbegin() const noexcept {return container_.cbegin();}
+    const_iterator cend()   const noexcept {return container_.cend();}
+
+    reverse_iterator       rbegin()        noexcept {return container_.rbegin();}
+    reverse_iterator       rend()          noexcept {return container_.rend();}
+    const_reverse_iterator rbegin()  const noexcept {return container_.rbegin();}
+    const_reverse_iterator rend()    const noexcept {return container_.rend();}
+    const_reverse_iterator crbegin() const noexcept {return container_.crbegin();}
+    const_reverse_iterator crend()   const noexcept {return container_.crend();}
+
+    // capacity -------------------------------------------------------------
+
+    bool      empty()    const noexcept {return container_.empty();}
+    size_type size()     const noexcept {return container_.size();}
+    size_type max_size() const noexcept {return container_.max_size();}
+    size_type capacity() const noexcept {return container_.capacity();}
+
+    void reserve(size_type n) {container_.reserve(n);}
+    void shrink_to_fit()      {container_.shrink_to_fit();}
+
+    // element access -------------------------------------------------------
+
+    mapped_type& at(const key_type& k)
+    {
+        const auto found = this->find(k);
+        if(found == this->end())
+        {
+            throw std::out_of_range("toml::flat_map::at: key not found");
+        }
+        return found->second;
+    }
+    mapped_type const& at(const key_type& k) const
+    {
+        const auto found = this->find(k);
+        if(found == this->end())
+        {
+            throw std::out_of_range("toml::flat_map::at: key not found");
+        }
+        return found->second;
+    }
+
+    mapped_type& operator[](const key_type& k)
+    {
+        return this->try_emplace(k).first->second;
+    }
+    mapped_type& operator[](key_type&& k)
+    {
+        return this->try_emplace(std::move(k)).first->second;
+    }
+
+    // modifiers ------------------------------------------------------------
+
+    void clear() noexcept {container_.clear();}
+
+    std::pair<iterator, bool> insert(const value_type& v)
+    {
+        const auto pos = this->insert_position(v.first);
+        if(!pos.second) {return std::make_pair(pos.first, false);}
+        return std::make_pair(container_.insert(pos.first, v), true);
+    }
+    std::pair<iterator, bool> insert(value_type&& v)
+    {
+        const auto pos = this->insert_position(v.first);
+        if(!pos.second) {return std::make_pair(pos.first, false);}
+        return std::make_pair(container_.insert(pos.first, std::move(v)), true);
+    }
+    template<typename P, typename std::enable_if<
+        std::is_constructible<value_type, P&&>::value, std::nullptr_t
+        >::type = nullptr>
+    std::pair<iterator, bool> insert(P&& p)
+    {
+        return this->insert(value_type(std::forward<P>(p)));
+    }
+
+    // Inserting a range appends everything and sorts once. The sort is stable
+    // so, like std::map, an element already in the table wins over a new one
+    // with the same key, and the first of the duplicates in the range wins.
+    template<typename InputIterator>
+    void insert(InputIterator first, InputIterator last)
+    {
+        const auto old_size = container_.size();
+        for(; first != last; ++first)
+        {
+            container_.emplace_back(*first);
+        }
+        if(container_.size() == old_size) {return;}
+
+        const auto middle = container_.begin() +
+            static_cast<difference_type>(old_size);
+        const auto comp = this->value_comp();
+        std::stable_sort(middle, container_.end(), comp);
+        std::inplace_merge(container_.begin(), middle, container_.end(), comp);
+        container_.erase(std::unique(container_.begin(), container_.end(),
+            [this](const value_type& lhs, const value_type& rhs) {
+                return !comp_(lhs.first, rhs.first);
+            }), container_.end());
+    }
+    void insert(std::initializer_list<value_type> list)
+    {
+        this->insert(list.begin(), list.end());
+    }
+
+    template<typename ... Args>
+    std::pair<iterator, bool> emplace(Args&& ... args)
+    {
+        return this->insert(value_type(std::forward<Args>(args)...));
+    }
+
+    template<typename ... Args>
+    std::pair<iterator, bool> try_emplace(const key_type& k, Args&& ... args)
+    {
+        const auto pos = this->insert_position(k);
+        if(!pos.second) {return std::make_pair(pos.first, false);}
+        return std::make_pair(container_.emplace(pos.first,
+            std::piecewise_construct, std::forward_as_tuple(k),
+            std::forward_as_tuple(std::forward<Args>(args)...)), true);
+    }
+    template<typename ... Args>
+    std::pair<iterator, bool> try_emplace(key_type&& k, Args&& ... args)
+    {
+        const auto pos = this->insert_position(k);
+        if(!pos.second) {return std::make_pair(pos.first, false);}
+        return std::make_pair(container_.emplace(pos.first,
+            std::piecewise_construct, std::forward_as_tuple(std::move(k)),
+            std::forward_as_tuple(std::forward<Args>(args)...)), true);
+    }
+
+    template<typename M>
+    std::pair<iterator, bool> insert_or_assign(const key_type& k, M&& obj)
+    {
+        const auto found = this->try_emplace(k, std::forward<M>(obj));
+        if(!found.second) {found.first->second = std::forward<M>(obj);}
+        return found;
+    }
+
+    iterator erase(const_iterator pos)
+    {
+        return container_.erase(pos);
+    }
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        return container_.erase(first, last);
+    }
+    size_type erase(const key_type& k)
+    {
+        const auto found = this->find(k);
+        if(found == this->end()) {return 0;}
+        container_.erase(found);
+        return 1;
+    }
+
+    void swap(flat_map& other)
+    {
+        using std::swap;
+        swap(container_, other.container_);
+        swap(comp_,      other.comp_);
+    }
+
+    // lookup ---------------------------------------------------------------
+
+    size_type count(const key_type& k) const
+    {
+        return this->find(k) == this->end() ? 0 : 1;
+    }
+    bool contains(const key_type& k) const
+    {
+        return this->find(k) != this->end();
+    }
+
+    iterator find(const key_type& k)
+    {
+        const auto found = this->lower_bound(k);
+        if(found == this->end() || comp_(k, found->first)) {return this->end();}
+        return found;
+    }
+    const_iterator find(const key_type& k) const
+    {
+        const auto found = this->lower_bound(k);
+        if(found == this->end() || comp_(k, found->first)) {return this->end();}
+        return found;
+    }
+
+    iterator lower_bound(const key_type& k)
+    {
+        return std::lower_bound(container_.begin(), container_.end(), k,
+            [this](const value_type& v, const key_type& key) {
+                return comp_(v.first, key);
+            });
+    }
+    const_iterator lower_bound(const key_type& k) const
+    {
+        return std::lower_bound(container_.begin(), container_.end(), k,
+            [this](const value_type& v, const key_type& key) {
+                return comp_(v.first, key);
+            });
+    }
+    iterator upper_bound(const key_type& k)
+    {
+        return std::upper_bound(container_.begin(), container_.end(), k,
+            [this](const key_type& key, const value_type& v) {
+                return comp_(key, v.first);
+            });
+    }
+    const_iterator upper_bound(const key_type& k) const
+    {
+        return std::upper_bound(container_.begin(), container_.end(), k,
+            [this](const key_type& key, const value_type& v) {
+                return comp_(key, v.first);
+            });
+    }
+    std::pair<iterator, iterator> equal_range(const key_type& k)
+    {
+        const auto first = this->lower_bound(k);
+        auto last = first;
+        if(last != this->end() && !comp_(k, last->first)) {++last;}
+        return std::make_pair(first, last);
+    }
+    std::pair<const_iterator, const_iterator>
+    equal_range(const key_type& k) const
+    {
+        const auto first = this->lower_bound(k);
+        auto last = first;
+        if(last != this->end() && !comp_(k, last->first)) {++last;}
+        return std::make_pair(first, last);
+    }
+
+    // observers ------------------------------------------------------------
+
+    class value_compare
+    {
+      public:
+        bool operator()(const value_type& lhs, const value_type& rhs) const
+        {
+            return comp_(lhs.first, rhs.first);
+        }
+      private:
+        friend class flat_map;
+        explicit value_compare(key_compare comp): comp_(comp) {}
+        key_compare comp_;
+    };
+
+    key_compare   key_comp()   const {return comp_;}
+    value_compare value_comp() const {return value_compare(comp_);}
+    allocator_type get_allocator() const {return container_.get_allocator();}
+
+    friend bool operator==(const flat_map& lhs, const flat_map& rhs)
+    {
+        return lhs.container_ == rhs.container_;
+    }
+    friend bool operator!=(const flat_map& lhs, const flat_map& rhs)
+    {
+        return !(lhs == rhs);
+    }
+    friend bool operator< (const flat_map& lhs, const flat_map& rhs)
+    {
+        return lhs.container_ < rhs.container_;
+    }
+    friend bool operator<=(const flat_map& lhs, const flat_map& rhs)
+    {
+        return !(rhs < lhs);
+    }
+    friend bool operator> (const flat_map& lhs, const flat_map& rhs)
+    {
+        return rhs < lhs;
+    }
+    friend bool operator>=(const flat_map& lhs, const flat_map& rhs)
+    {
+        return !(lhs < rhs);
+    }
+    friend void swap(flat_map& lhs, flat_map& rhs) {lhs.swap(rhs);}
+
+  private:
+
+    // Returns where `k` belongs and whether it is missing from the table. The
+    // back of the table is checked first so that appending in key order does
+    // not need a binary search.
+    std::pair<iterator, bool> insert_position(const key_type& k)
+    {
+        if(container_.empty() || comp_(container_.back().first, k))
+        {
+            return std::make_pair(container_.end(), true);
+        }
+        const auto found = this->lower_bound(k);
+        return std::make_pair(found, comp_(k, found->first));
+    }
+
+  private:
+
+    container_type container_;
+    key_compare    comp_;
+};
+
+} // toml
+#endif// TOML11_FLAT_MAP_HPP
@@ -0,0 +1,488 @@
+// Distributed under the MIT License.
+#ifndef TOML11_LAZY_HPP
+#define TOML11_LAZY_HPP
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "get.hpp"
+#include "parser.hpp"
+
+// A document whose top-level entries are parsed on demand.
+//
+// `toml::parse_lazy` only scans the structure of a file: it finds the table
+// headers and the top-level keys, skips over the values, and records where
+// each top-level entry is defined. An entry is parsed when it is looked up for
+// the first time, through `toml::find`, `toml::find_or` or `at`, so the cost of
+// reading a large file that is mostly ignored (e.g. a file shared by several
+// tools) depends on the entries that are actually read.
+//
+// ```cpp
+// auto config = toml::parse_lazy("Polybuild.toml");
+// const auto& paths  = toml::find(config, "paths"); // parses [paths] and [paths.*]
+// const auto  output = toml::find<std::string>(paths, "output");
+// ```
+//
+// Errors in an entry are reported when it is parsed, so errors in entries that
+// are never read go unnoticed.
+
+namespace toml
+{
+namespace detail
+{
+
+// skips a string literal that starts at `iter` and returns the position after
+// it. if it is not terminated on the line (or, for multi-line ones, at all),
+// returns the position of the newline (or `last`), and leaves the error to be
+// reported when the entry is parsed.
+inline const char* skip_string_structure(const char* iter, const char* last)
+{
+    const char quote = *iter;
+    const bool is_basic = quote == '"';
+    const bool is_multiline = last - iter >= 3 &&
+        iter[1] == quote && iter[2] == quote;
+
+    if(is_multiline)
+    {
+        iter += 3;
+        while(iter != last)
+        {
+            if(is_basic)
+            {
+                iter = scan_while<ml_basic_unescaped_chars>(iter, last);
+                if(iter == last) {break;}
+            }
+            if(is_basic && *iter == '\\')
+            {
+                iter += (last - iter >= 2) ? 2 : 1;
+                continue;
+            }
+            if(*iter == quote && last - iter >= 3 &&
+               iter[1] == quote && iter[2] == quote)
+            {
+                iter += 3;
+                // one or two quotes just before the delimiter are a part of
+                // the string. see lex_ml_basic_string_close.
+                for(int i=0; i<2 && iter != last && *iter == quote; ++i) {++iter;}
+                return iter;
+            }
+            ++iter;
+        }
+        return last;
+    }
+
+    ++iter;
+    while(iter != last && *iter != '\n')
+    {
+        if(is_basic)
+        {
+            iter = scan_while<basic_unescaped_chars>(iter, last);
+            if(iter == last || *iter == '\n') {break;}
+        }
+        if(is_basic && *iter == '\\')
+        {
+            iter += (last - iter >= 2 && iter[1] != '\n') ? 2 : 1;
+            continue;
+        }
+        if(*iter == quote)
+        {
+            return ++iter;
+        }
+        ++iter;
+    }
+    return iter;
+}
+
+// skips the value of a key-value pair, from just after `=`, and returns the
+// position of the newline that ends it. strings (that may contain brackets,
+// `#` or newlines) and arrays and inline tables (that may span several lines)
+// are skipped as a whole. nothing is checked here; the value is checked when
+// the entry is parsed.
+inline const char* skip_value_structure(const char* iter, const char* last)
+{
+    std::size_t depth = 0;
+    while(iter != last)
+    {
+        const char c = *iter;
+        if(c == '"' || c == '\'')
+        {
+            iter = skip_string_structure(iter, last);
+            continue;
+        }
+        if(c == '#')
+        {
+            iter = std::find(iter, last, '\n');
+            continue;
+        }
+        if(c == '[' || c == '{')
+        {
+            ++depth;
+        }
+        else if((c == ']' || c == '}') && depth != 0)
+        {
+            --depth;
+        }
+        else if(c == '\n' && depth == 0)
+        {
+            return iter;
+        }
+        ++iter;
+    }
+    return last;
+}
+
+} // detail
+
+template<typename                     Comment = TOML11_DEFAULT_COMMENT_STRATEGY,
+         template<typename ...> class Table   = std::unordered_map,
+         template<typename ...> class Array   = std::vector>
+class basic_lazy_document
+{
+  public:
+
+    using value_type = basic_value<Comment, Table, Array>;
+    using table_type = typename value_type::table_type;
+    using source_ptr = detail::location::source_ptr;
+
+    // `source` must end with a newline, like the source of detail::parse.
+    explicit basic_lazy_document(source_ptr source)
+        : source_(std::move(source)),
+          root_(table_type{}, this->root_region(), {})
+    {
+        this->scan();
+    }
+
+    basic_lazy_document(basic_lazy_document&&)            = default;
+    basic_lazy_document& operator=(basic_lazy_document&&) = default;
+    ~basic_lazy_document() = default;
+
+    std::string const& name() const noexcept {return source_->name();}
+
+    bool contains(const key& k) const
+    {
+        return this->entries_.count(k) != 0;
+    }
+    std::size_t size() const noexcept {return this->entries_.size();}
+
+    // top-level keys, in lexicographical order.
+    std::vector<key> keys() const
+    {
+        std::vector<key> retval;
+        retval.reserve(this->entries_.size());
+        for(const auto& kv : this->entries_) {retval.push_back(kv.first);}
+        return retval;
+    }
+
+    // parses the entry on the first call. The returned reference stays valid
+    // as long as the document does.
+    value_type const& at(const key& k)
+    {
+        const auto found = this->entries_.find(k);
+        if(found == this->entries_.end())
+        {
+            // throws std::out_of_range with the same message as toml::find
+            return this->root_.at(k);
+        }
+        entry& e = found->second;
+        if(!e.value)
+        {
+            e.value.reset(new value_type(this->parse_entry(k, e.offsets)));
+        }
+        return *e.value;
+    }
+
+    // parses all the entries and returns the whole document. The comments
+    // for the file itself are not kept.
+    value_type value()
+    {
+        table_type tab;
+        for(const auto& kv : this->entries_)
+        {
+            tab[kv.first] = this->at(kv.first);
+        }
+        value_type retval(this->root_);
+        retval.as_table() = std::move(tab);
+        return retval;
+    }
+
+  private:
+
+    struct entry
+    {
+        // where the entry is defined: key-value pairs in the top-level table
+        // and [table] or [[array.of.tables]] headers, from the beginning of
+        // the source.
+        std::vector<std::size_t>    offsets;
+        std::unique_ptr<value_type> value;
+    };
+
+    detail::region root_region() const
+    {
+        // see parse_toml_file
+        detail::location loc(source_);
+        const auto first = loc.iter();
+        return detail::region(loc, first,
+                first == loc.end() ? first : std::next(first));
+    }
+
+    // finds the top-level entries. This does not build any value.
+    void scan()
+    {
+        using namespace detail;
+
+        location loc(source_);
+        const auto first = loc.iter();
+        const auto last  = loc.end();
+
+        // skip BOM if exists. see detail::parse(location).
+        auto iter = first;
+        if(last - first >= 3 && static_cast<unsigned char>(first[0]) == 0xEF &&
+           static_cast<unsigned char>(first[1]) == 0xBB &&
+           static_cast<unsigned char>(first[2]) == 0xBF)
+        {
+            iter += 3;
+        }
+
+        bool in_top_level = true;
+        while(iter != last)
+        {
+            iter = scan_while<whitespace_chars>(iter, last);
+            if(iter == last) {break;}
+            if(*iter == '\n' || *iter == '\r')
+            {
+                ++iter;
+                continue;
+            }
+            loc.reset(iter);
+            if(*iter == '#')
+            {
+                // comments between the entries do not belong to any of them,
+                // so they are checked here.
+                lex_comment::invoke(loc);
+                if(loc.iter() != last && *loc.iter() != '\n' && *loc.iter() != '\r')
+                {
+                    throw syntax_error(format_underline("toml::parse_lazy: "
+                        "invalid character in a comment", {{source_location(loc),
+                        "here"}}), source_location(loc));
+                }
+                iter = loc.iter();
+                continue;
+            }
+
+            const auto offset = static_cast<std::size_t>(iter - first);
+            if(*iter == '[')
+            {
+                result<std::pair<std::vector<key>, region>, std::string>
+                    tabkey = err(std::string("not a table header"));
+                if(is_array_table_key_head(loc)) {tabkey = parse_array_table_key(loc);}
+                if(!tabkey) {tabkey = parse_table_key(loc);}
+                if(!tabkey)
+                {
+                    throw syntax_error(format_underline("toml::parse_lazy: "
+                        "unknown line appeared", {{source_location(loc),
+                        "unknown format"}}), source_location(loc));
+                }
+                entries_[tabkey.unwrap().first.front()].offsets.push_back(offset);
+                in_top_level = false;
+                iter = loc.iter();
+                continue;
+            }
+
+            // key = value. Only the ones before the first table header are
+            // in the top-level table; the others are skipped.
+            if(in_top_level)
+            {
+                const auto keys = parse_key(loc);
+                if(!keys)
+                {
+                    throw syntax_error(keys.unwrap_err(), source_location(loc));
+                }
+                entries_[keys.unwrap().first.front()].offsets.push_back(offset);
+            }
+            else if(!lex_key::invoke(loc))
+            {
+                throw syntax_error(format_underline("toml::parse_lazy: "
+                    "invalid key", {{source_location(loc), "not a key"}}),
+                    source_location(loc));
+            }
+            if(!lex_keyval_sep::invoke(loc))
+            {
+                throw syntax_error(format_underline("toml::parse_lazy: "
+                    "missing key-value separator `=`",
+                    {{source_location(loc), "should be `=`"}}),
+                    source_location(loc));
+            }
+            iter = skip_value_structure(loc.iter(), last);
+        }
+    }
+
+    // parses all the definitions of an entry, the same way as parse_toml_file.
+    value_type parse_entry(const key& k, const std::vector<std::size_t>& offsets) const
+    {
+        using namespace detail;
+
+        location loc(source_);
+        const auto first = loc.iter();
+
+        table_type data;
+        for(const auto offset : offsets)
+        {
+            loc.reset(first + offset);
+            if(is_array_table_key_head(loc))
+            {
+                if(const auto tabkey = parse_array_table_key(loc))
+                {
+                    this->insert_table(data, tabkey.unwrap(), loc, true);
+                    continue;
+                }
+            }
+            if(is_table_key_head(loc))
+            {
+                if(const auto tabkey = parse_table_key(loc))
+                {
+                    this->insert_table(data, tabkey.unwrap(), loc, false);
+                    continue;
+                }
+            }
+
+            const auto kv = parse_key_value_pair<value_type>(loc, 0);
+            if(!kv)
+            {
+                throw syntax_error(kv.unwrap_err(), source_location(loc));
+            }
+            const auto& keys    = kv.unwrap().first.first;
+            const auto& key_reg = kv.unwrap().first.second;
+            const auto inserted = insert_nested_key(data, kv.unwrap().second,
+                    keys.begin(), keys.end(), key_reg);
+            if(!inserted)
+            {
+                throw syntax_error(inserted.unwrap_err(), source_location(loc));
+            }
+
+            // see parse_ml_table
+            using lex_line_end = sequence<maybe<lex_ws>, maybe<lex_comment>,
+                                          lex_newline>;
+            if(!lex_line_end::invoke(loc) && loc.iter() != loc.end())
+            {
+                lex_ws::invoke(loc);
+                throw syntax_error(format_underline("toml::parse_table: "
+                    "invalid line format", {{source_location(loc), concat_to_string(
+                    "expected newline, but got '", show_char(*loc.iter()), "'.")}}),
+                    source_location(loc));
+            }
+        }
+        return std::move(data.at(k));
+    }
+
+    void insert_table(table_type& data,
+                      const std::pair<std::vector<key>, detail::region>& tabkey,
+                      detail::location& loc, const bool is_array_of_table) const
+    {
+        using namespace detail;
+
+        const auto tab = parse_ml_table<value_type>(loc);
+        if(!tab)
+        {
+            throw syntax_error(tab.unwrap_err(), source_location(loc));
+        }
+        const auto& keys = tabkey.first;
+        const auto& reg  = tabkey.second;
+        const auto inserted = insert_nested_key(data,
+                value_type(tab.unwrap(), reg, comments_of<value_type>(reg)),
+                keys.begin(), keys.end(), reg, is_array_of_table);
+        if(!inserted)
+        {
+            throw syntax_error(inserted.unwrap_err(), source_location(loc));
+        }
+    }
+
+  private:
+
+    source_ptr             source_;
+    value_type             root_; // an empty table, for error messages
+    std::map<key, entry>   entries_;
+};
+
+using lazy_document = basic_lazy_document<>;
+
+template<typename                     Comment = TOML11_DEFAULT_COMMENT_STRATEGY,
+         template<typename ...> class Table   = std::unordered_map,
+         template<typename ...> class Array   = std::vector>
+basic_lazy_document<Comment, Table, Array> parse_lazy(std::string fname)
+{
+    using document_type = basic_lazy_document<Comment, Table, Array>;
+#ifdef TOML11_HAS_MMAP
+    if(auto source = detail::map_file(fname))
+    {
+        return document_type(std::move(source));
+    }
+#endif
+    std::ifstream ifs(fname, std::ios_base::binary);
+    if(!ifs.good())
+    {
+        throw std::ios_base::failure(
+                "toml::parse_lazy: Error opening file \"" + fname + "\"");
+    }
+    ifs.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    std::vector<char> letters{std::istreambuf_iterator<char>(ifs),
+                              std::istreambuf_iterator<char>()};
+
+    // append LF. see detail::parse(std::vector<char>&, fname).
+    if(!letters.empty() && letters.back() != '\n' && letters.back() != '\r')
+    {
+        letters.push_back('\n');
+    }
+    return document_type(std::make_shared<detail::source_buffer>(
+                std::move(fname), std::move(letters)));
+}
+
+// ---------------------------------------------------------------------------
+// find(document, key, ...) and find_or(document, key, fallback). The first key
+// is looked up in the document and the rest as usual.
+
+template<typename C,
+         template<typename ...> class M, template<typename ...> class V>
+basic_value<C, M, V> const&
+find(basic_lazy_document<C, M, V>& doc, const key& ky)
+{
+    return doc.at(ky);
+}
+
+template<typename T, typename C,
+         template<typename ...> class M, template<typename ...> class V>
+decltype(::toml::get<T>(std::declval<basic_value<C, M, V> const&>()))
+find(basic_lazy_document<C, M, V>& doc, const key& ky)
+{
+    return ::toml::get<T>(doc.at(ky));
+}
+
+template<typename C,
+         template<typename ...> class M, template<typename ...> class V,
+         typename Key, typename ... Keys>
+auto find(basic_lazy_document<C, M, V>& doc, const key& ky, Key&& k, Keys&& ... ks)
+    -> decltype(::toml::find(doc.at(ky), std::forward<Key>(k), std::forward<Keys>(ks)...))
+{
+    return ::toml::find(doc.at(ky), std::forward<Key>(k), std::forward<Keys>(ks)...);
+}
+
+template<typename T, typename C,
+         template<typename ...> class M, template<typename ...> class V,
+         typename Key, typename ... Keys>
+auto find(basic_lazy_document<C, M, V>& doc, const key& ky, Key&& k, Keys&& ... ks)
+    -> decltype(::toml::find<T>(doc.at(ky), std::forward<Key>(k), std::forward<Keys>(ks)...))
+{
+    return ::toml::find<T>(doc.at(ky), std::forward<Key>(k), std::forward<Keys>(ks)...);
+}
+
+template<typename T, typename C,
+         template<typename ...> class M, template<typename ...> class V>
+T find_or(basic_lazy_document<C, M, V>& doc, const key& ky, const T& opt)
+{
+    if(!doc.contains(ky)) {return opt;}
+    return get_or(doc.at(ky), opt);
+}
+
+} // toml
+#endif// TOML11_LAZY_HPP
@@ -286,8 +286,59 @@ using lex_utf8_code = either<
 
 using lex_comment_start_symbol = character<'#'>;
 using lex_non_eol_ascii = either<character<0x09>, in_range<0x20, 0x7E>>;
-using lex_comment = sequence<lex_comment_start_symbol, repeat<either<
-    lex_non_eol_ascii, lex_utf8_2byte, lex_utf8_3byte, lex_utf8_4byte>, unlimited>>;
+using lex_comment_char  = either<lex_non_eol_ascii,
+                                lex_utf8_2byte, lex_utf8_3byte, lex_utf8_4byte>;
+using lex_comment = sequence<lex_comment_start_symbol,
+                             repeat<lex_comment_char, unlimited>>;
+
+// ===========================================================================
+// The repetitions below consume long runs of characters (whitespace, comments
+// and string bodies), so they skip the characters that need no further check
+// in bulk. see scan_repeat in combinator.hpp. they behave the same as the
+// generic repeat<T, N>.
+
+template<>
+struct repeat<lex_wschar, at_least<1>>
+    : scan_repeat<lex_wschar, whitespace_chars, 1>
+{};
+
+template<>
+struct repeat<lex_comment_char, unlimited>
+    : scan_repeat<lex_comment_char, non_eol_ascii_chars, 0>
+{};
+
+template<>
+struct repeat<lex_basic_char, unlimited>
+    : scan_repeat<lex_basic_char, basic_unescaped_chars, 0>
+{};
+
+template<>
+struct repeat<lex_basic_unescaped, unlimited>
+    : scan_repeat<lex_basic_unescaped, basic_unescaped_chars, 0>
+{};
+
+template<>
+struct repeat<either<lex_ml_basic_char, lex_newline,
+                     lex_ml_basic_escaped_newline>, unlimited>
+    : scan_repeat<either<lex_ml_basic_char, lex_newline,
+                         lex_ml_basic_escaped_newline>,
+                  ml_basic_unescaped_chars, 0>
+{};
+
+// used by parse_ml_basic_string.
+template<>
+struct repeat<either<lex_ml_basic_unescaped, lex_newline>, unlimited>
+    : scan_repeat<either<lex_ml_basic_unescaped, lex_newline>,
+                  ml_basic_unescaped_chars, 0>
+{};
+
+// used by parse_array to skip whitespace, newlines and comments between the
+// elements.
+template<>
+struct repeat<either<lex_wschar, lex_newline, lex_comment>, unlimited>
+    : scan_repeat<either<lex_wschar, lex_newline, lex_comment>,
+                  whitespace_newline_chars, 0>
+{};
 
 } // detail
 } // toml
@@ -3,9 +3,11 @@
 #ifndef TOML11_PARSER_HPP
 #define TOML11_PARSER_HPP
 #include <cstring>
+#include <deque>
 #include <fstream>
 #include <sstream>
 
+#include "arena.hpp"
 #include "combinator.hpp"
 #include "lexer.hpp"
 #include "macros.hpp"
@@ -23,6 +25,29 @@
 #endif // __cpp_lib_filesystem
 #endif // TOML11_DISABLE_STD_FILESYSTEM
 
+#ifndef TOML11_DISABLE_MMAP
+#if defined(__unix__) || (defined(__APPLE__) && defined(__MACH__))
+#define TOML11_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // unix
+#endif // TOML11_DISABLE_MMAP
+
+#ifndef TOML11_DISABLE_STD_FROM_CHARS
+#if TOML11_CPLUSPLUS_STANDARD_VERSION >= 201703L
+#if __has_include(<charconv>)
+#define TOML11_HAS_STD_FROM_CHARS
+#include <charconv>
+// std::from_chars for floating-point types arrived later than for integers.
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+#define TOML11_HAS_STD_FROM_CHARS_FLOATING
+#endif
+#endif // has_include(<charconv>)
+#endif // c++17
+#endif // TOML11_DISABLE_STD_FROM_CHARS
+
 // the previous commit works with 500+ recursions. so it may be too small.
 // but in most cases, i think we don't need such a deep recursion of
 // arrays or inline-tables.
@@ -55,68 +80,104 @@ parse_boolean(location& loc)
                {{source_location(loc), "the next token is not a boolean"}}));
 }
 
+// Copies a number token into `buf` without `_`s and a leading `+`, and returns
+// the end of the copied characters. Tokens longer than the buffer (possible
+// only with many leading zeros or `_`s) are copied into `large` instead.
+template<std::size_t N>
+std::pair<const char*, const char*> strip_underscores(
+    const char* first, const char* last, std::array<char, N>& buf,
+    std::string& large)
+{
+    if(first != last && *first == '+') {++first;}
+    if(static_cast<std::size_t>(std::distance(first, last)) <= buf.size())
+    {
+        const auto end = std::remove_copy(first, last, buf.begin(), '_');
+        return std::make_pair(buf.data(), buf.data() + std::distance(buf.begin(), end));
+    }
+    large.assign(first, last);
+    large.erase(std::remove(large.begin(), large.end(), '_'), large.end());
+    return std::make_pair(large.data(), large.data() + large.size());
+}
+
+// Converts the digits of an integer token in [first, last) into `value`. The
+// token is already checked by the lexer, so this fails only if the value does
+// not fit in an integer.
+inline bool read_integer(const char* first, const char* last, const int base,
+                         integer& value)
+{
+    std::array<char, 32> buf;
+    std::string large;
+    const auto digits = strip_underscores(first, last, buf, large);
+#ifdef TOML11_HAS_STD_FROM_CHARS
+    const auto result = std::from_chars(digits.first, digits.second, value, base);
+    return result.ec == std::errc() && result.ptr == digits.second;
+#else
+    if(base == 2) // istream does not support base 2. binaries have no sign.
+    {
+        value = 0;
+        for(auto iter = digits.first; iter != digits.second; ++iter)
+        {
+            const integer digit = *iter - '0';
+            if(value > ((std::numeric_limits<integer>::max)() - digit) / 2)
+            {
+                return false;
+            }
+            value = value * 2 + digit;
+        }
+        return true;
+    }
+    std::istringstream iss(std::string(digits.first, digits.second));
+    iss >> std::setbase(base) >> value;
+    // `istream` sets `failbit` if internally-called `std::num_get::get`
+    // fails. `std::num_get::get` calls `std::strtoll` if the argument type is
+    // signed. `std::strtoll` fails if the value is out_of_range or no
+    // conversion is possible. since the lexer already checked that the string
+    // is a valid integer, the error reason is out_of_range.
+    return !iss.fail();
+#endif
+}
+
+// Converts a float token (other than inf and nan) in [first, last) into
+// `value`. Like read_integer, this fails only if the value is out of range.
+inline bool read_floating(const char* first, const char* last, floating& value)
+{
+    std::array<char, 64> buf;
+    std::string large;
+    const auto digits = strip_underscores(first, last, buf, large);
+#ifdef TOML11_HAS_STD_FROM_CHARS_FLOATING
+    const auto result = std::from_chars(digits.first, digits.second, value);
+    if(result.ec == std::errc() && result.ptr == digits.second)
+    {
+        return true;
+    }
+    // from_chars also refuses values that underflow to zero or a subnormal,
+    // which the stream-based conversion below accepts. let it decide.
+#endif
+    std::istringstream iss(std::string(digits.first, digits.second));
+    iss >> value;
+    return !iss.fail();
+}
+
 inline result<std::pair<integer, region>, std::string>
 parse_binary_integer(location& loc)
 {
     const auto first = loc.iter();
     if(const auto token = lex_bin_int::invoke(loc))
     {
-        auto str = token.unwrap().str();
-        assert(str.size() > 2); // minimum -> 0b1
-        assert(str.at(0) == '0' && str.at(1) == 'b');
-
-        // skip all the zeros and `_` locating at the MSB
-        str.erase(str.begin(), std::find_if(
-                str.begin() + 2, // to skip prefix `0b`
-                str.end(),
-                [](const char c) { return c == '1'; })
-            );
-        assert(str.empty() || str.front() == '1');
+        const auto& reg = token.unwrap();
+        assert(reg.size() > 2); // minimum -> 0b1
+        assert(reg.first()[0] == '0' && reg.first()[1] == 'b');
 
         // since toml11 uses int64_t, 64bit (unsigned) input cannot be read.
-        const auto max_length = 63 + std::count(str.begin(), str.end(), '_');
-        if(static_cast<std::string::size_type>(max_length) < str.size())
+        integer retval(0);
+        if(!read_integer(reg.first() + 2, reg.last(), 2, retval))
         {
             loc.reset(first);
             return err(format_underline("toml::parse_binary_integer: "
                 "only signed 64bit integer is available",
                {{source_location(loc), "too large input (> int64_t)"}}));
         }
-
-        integer retval(0), base(1);
-        for(auto i(str.rbegin()), e(str.rend()); i!=e; ++i)
-        {
-            assert(base != 0); // means overflow, checked in the above code
-            if(*i == '1')
-            {
-                retval += base;
-                if( (std::numeric_limits<integer>::max)() / 2 < base )
-                {
-                    base = 0;
-                }
-                base *= 2;
-            }
-            else if(*i == '0')
-            {
-                if( (std::numeric_limits<integer>::max)() / 2 < base )
-                {
-                    base = 0;
-                }
-                base *= 2;
-            }
-            else if(*i == '_')
-            {
-                // do nothing.
-            }
-            else // should be detected by lex_bin_int. [[unlikely]]
-            {
-                throw internal_error(format_underline(
-                    "toml::parse_binary_integer: internal error",
-                    {{source_location(token.unwrap()), "invalid token"}}),
-                    source_location(loc));
-            }
-        }
-        return ok(std::make_pair(retval, token.unwrap()));
+        return ok(std::make_pair(retval, reg));
     }
     loc.reset(first);
     return err(format_underline("toml::parse_binary_integer:",
@@ -129,29 +190,16 @@ parse_octal_integer(location& loc)
     const auto first = loc.iter();
     if(const auto token = lex_oct_int::invoke(loc))
     {
-        auto str = token.unwrap().str();
-        str.erase(std::remove(str.begin(), str.end(), '_'), str.end());
-        str.erase(str.begin()); str.erase(str.begin()); // remove `0o` prefix
-
-        std::istringstream iss(str);
+        // skip `0o` prefix
+        const auto& reg = token.unwrap();
         integer retval(0);
-        iss >> std::oct >> retval;
-        if(iss.fail())
-        {
-            // `istream` sets `failbit` if internally-called `std::num_get::get`
-            // fails.
-            // `std::num_get::get` calls `std::strtoll` if the argument type is
-            // signed.
-            // `std::strtoll` fails if
-            //  - the value is out_of_range or
-            //  - no conversion is possible.
-            // since we already checked that the string is valid octal integer,
-            // so the error reason is out_of_range.
+        if(!read_integer(reg.first() + 2, reg.last(), 8, retval))
+        {
             loc.reset(first);
             return err(format_underline("toml::parse_octal_integer:",
                        {{source_location(loc), "out of range"}}));
         }
-        return ok(std::make_pair(retval, token.unwrap()));
+        return ok(std::make_pair(retval, reg));
     }
     loc.reset(first);
     return err(format_underline("toml::parse_octal_integer:",
@@ -164,21 +212,16 @@ parse_hexadecimal_integer(location& loc)
     const auto first = loc.iter();
     if(const auto token = lex_hex_int::invoke(loc))
     {
-        auto str = token.unwrap().str();
-        str.erase(std::remove(str.begin(), str.end(), '_'), str.end());
-        str.erase(str.begin()); str.erase(str.begin()); // remove `0x` prefix
-
-        std::istringstream iss(str);
+        // skip `0x` prefix
+        const auto& reg = token.unwrap();
         integer retval(0);
-        iss >> std::hex >> retval;
-        if(iss.fail())
+        if(!read_integer(reg.first() + 2, reg.last(), 16, retval))
         {
-            // see parse_octal_integer for detail of this error message.
             loc.reset(first);
             return err(format_underline("toml::parse_hexadecimal_integer:",
                        {{source_location(loc), "out of range"}}));
         }
-        return ok(std::make_pair(retval, token.unwrap()));
+        return ok(std::make_pair(retval, reg));
     }
     loc.reset(first);
     return err(format_underline("toml::parse_hexadecimal_integer",
@@ -218,20 +261,15 @@ parse_integer(location& loc)
 
     if(const auto token = lex_dec_int::invoke(loc))
     {
-        auto str = token.unwrap().str();
-        str.erase(std::remove(str.begin(), str.end(), '_'), str.end());
-
-        std::istringstream iss(str);
+        const auto& reg = token.unwrap();
         integer retval(0);
-        iss >> retval;
-        if(iss.fail())
+        if(!read_integer(reg.first(), reg.last(), 10, retval))
         {
-            // see parse_octal_integer for detail of this error message.
             loc.reset(first);
             return err(format_underline("toml::parse_integer:",
                        {{source_location(loc), "out of range"}}));
         }
-        return ok(std::make_pair(retval, token.unwrap()));
+        return ok(std::make_pair(retval, reg));
     }
     loc.reset(first);
     return err(format_underline("toml::parse_integer: ",
@@ -244,8 +282,12 @@ parse_floating(location& loc)
     const auto first = loc.iter();
     if(const auto token = lex_float::invoke(loc))
     {
-        auto str = token.unwrap().str();
-        if(str == "inf" || str == "+inf")
+        const auto& reg = token.unwrap();
+        const auto is = [&reg](const char* str) noexcept {
+            return reg.size() == std::strlen(str) &&
+                   std::equal(reg.first(), reg.last(), str);
+        };
+        if(is("inf") || is("+inf"))
         {
             if(std::numeric_limits<floating>::has_infinity)
             {
@@ -260,7 +302,7 @@ parse_floating(location& loc)
                     " IEEE 754/ISO 60559 international standard.");
             }
         }
-        else if(str == "-inf")
+        else if(is("-inf"))
         {
             if(std::numeric_limits<floating>::has_infinity)
             {
@@ -275,7 +317,7 @@ parse_floating(location& loc)
                     " IEEE 754/ISO 60559 international standard.");
             }
         }
-        else if(str == "nan" || str == "+nan")
+        else if(is("nan") || is("+nan"))
         {
             if(std::numeric_limits<floating>::has_quiet_NaN)
             {
@@ -295,7 +337,7 @@ parse_floating(location& loc)
                     " IEEE 754/ISO 60559 international standard.");
             }
         }
-        else if(str == "-nan")
+        else if(is("-nan"))
         {
             if(std::numeric_limits<floating>::has_quiet_NaN)
             {
@@ -315,18 +357,14 @@ parse_floating(location& loc)
                     " IEEE 754/ISO 60559 international standard.");
             }
         }
-        str.erase(std::remove(str.begin(), str.end(), '_'), str.end());
-        std::istringstream iss(str);
         floating v(0.0);
-        iss >> v;
-        if(iss.fail())
+        if(!read_floating(reg.first(), reg.last(), v))
         {
-            // see parse_octal_integer for detail of this error message.
             loc.reset(first);
             return err(format_underline("toml::parse_floating:",
                        {{source_location(loc), "out of range"}}));
         }
-        return ok(std::make_pair(v, token.unwrap()));
+        return ok(std::make_pair(v, reg));
     }
     loc.reset(first);
     return err(format_underline("toml::parse_floating: ",
@@ -1062,13 +1100,22 @@ parse_offset_datetime(location& loc)
 inline result<std::pair<key, region>, std::string>
 parse_simple_key(location& loc)
 {
-    if(const auto bstr = parse_basic_string(loc))
+    // look at the first character before trying quoted keys. a failed parser
+    // formats an error message, and most keys are bare.
+    const char head = loc.iter() != loc.end() ? *loc.iter() : '\0';
+    if(head == '"')
     {
-        return ok(std::make_pair(bstr.unwrap().first.str, bstr.unwrap().second));
+        if(const auto bstr = parse_basic_string(loc))
+        {
+            return ok(std::make_pair(bstr.unwrap().first.str, bstr.unwrap().second));
+        }
     }
-    if(const auto lstr = parse_literal_string(loc))
+    if(head == '\'')
     {
-        return ok(std::make_pair(lstr.unwrap().first.str, lstr.unwrap().second));
+        if(const auto lstr = parse_literal_string(loc))
+        {
+            return ok(std::make_pair(lstr.unwrap().first.str, lstr.unwrap().second));
+        }
     }
     if(const auto bare = lex_unquoted_key::invoke(loc))
     {
@@ -1146,6 +1193,19 @@ parse_key(location& loc)
 template<typename Value>
 result<Value, std::string> parse_value(location&, const std::size_t n_rec);
 
+// collects the comments of a value only if the value keeps them. looking for
+// comments scans the line that contains the value, so doing it for every
+// element of a long one-line array takes quadratic time.
+template<typename Value>
+std::vector<std::string> comments_of(const region& reg)
+{
+    if(std::is_same<typename Value::comment_type, discard_comments>::value)
+    {
+        return {};
+    }
+    return reg.comments();
+}
+
 template<typename Value>
 result<std::pair<typename Value::array_type, region>, std::string>
 parse_array(location& loc, const std::size_t n_rec)
@@ -1183,7 +1243,7 @@ parse_array(location& loc, const std::size_t n_rec)
         if(loc.iter() != loc.end() && *loc.iter() == ']')
         {
             loc.advance(); // skip ']'
-            return ok(std::make_pair(retval,
+            return ok(std::make_pair(std::move(retval),
                       region(loc, first, loc.iter())));
         }
 
@@ -1236,7 +1296,7 @@ parse_array(location& loc, const std::size_t n_rec)
             if(loc.iter() != loc.end() && *loc.iter() == ']')
             {
                 loc.advance(); // skip ']'
-                return ok(std::make_pair(retval,
+                return ok(std::make_pair(std::move(retval),
                           region(loc, first, loc.iter())));
             }
             else
@@ -1659,7 +1719,7 @@ insert_nested_key(typename Value::table_type& root, const Value& v,
                     std::vector<std::string> comments{/* empty by default */};
                     if(key_reg.str().substr(0, 2) != "[[")
                     {
-                        comments = key_reg.comments();
+                        comments = comments_of<value_type>(key_reg);
                     }
                     value_type aot(array_type(1, v), key_reg, std::move(comments));
                     tab->insert(std::make_pair(k, aot));
@@ -1939,6 +1999,46 @@ inline result<value_t, std::string> guess_number_type(const location& l)
     // spaces, tabs, commas (in an array or inline table), closing brackets
     // (of an array or inline table), comment-sign (#). Since this function
     // does not parse further, those characters are always allowed to be there.
+
+    // Most numbers are plain ones, like `42`, `-1` or `3.14`. A quick scan is
+    // enough to tell them from the others, without trying all the lexers
+    // below one by one. Anything else (`_`, prefixes, dates, inf, ...) goes
+    // through the lexers as usual.
+    {
+        auto iter = l.iter();
+        const auto last = l.end();
+        const auto skip_digits = [&iter, last]() noexcept -> bool {
+            const auto first = iter;
+            while(iter != last && '0' <= *iter && *iter <= '9') {++iter;}
+            return iter != first;
+        };
+        if(iter != last && (*iter == '+' || *iter == '-')) {++iter;}
+
+        const auto int_first = iter;
+        bool plain    = skip_digits() &&
+                        (*int_first != '0' || std::next(int_first) == iter);
+        bool is_float = false;
+        if(plain && iter != last && *iter == '.')
+        {
+            ++iter;
+            plain    = skip_digits();
+            is_float = true;
+        }
+        if(plain && iter != last && (*iter == 'e' || *iter == 'E'))
+        {
+            ++iter;
+            if(iter != last && (*iter == '+' || *iter == '-')) {++iter;}
+            plain    = skip_digits();
+            is_float = true;
+        }
+        if(plain && (iter == last || *iter == ' ' || *iter == '\t' ||
+                     *iter == '\r' || *iter == '\n' || *iter == ',' ||
+                     *iter == ']' || *iter == '}' || *iter == '#'))
+        {
+            return ok(is_float ? value_t::floating : value_t::integer);
+        }
+    }
+
     location loc = l;
 
     if(lex_offset_date_time::invoke(loc)) {return ok(value_t::offset_datetime);}
@@ -2090,7 +2190,7 @@ parse_value_helper(result<std::pair<T, region>, std::string> rslt)
 {
     if(rslt.is_ok())
     {
-        auto comments = rslt.as_ok().second.comments();
+        auto comments = comments_of<Value>(rslt.as_ok().second);
         return ok(Value(std::move(rslt.as_ok()), std::move(comments)));
     }
     else
@@ -2256,6 +2356,19 @@ parse_array_table_key(location& loc)
 }
 
 // parse table body (key-value pairs until the iter hits the next [tablekey])
+// a failed parse_table_key or parse_array_table_key formats an error message,
+// which costs far more than the parse itself. Loops that look for the next
+// table header check the first characters before trying them.
+inline bool is_table_key_head(const location& loc) noexcept
+{
+    return loc.iter() != loc.end() && *loc.iter() == '[';
+}
+inline bool is_array_table_key_head(const location& loc) noexcept
+{
+    return loc.end() - loc.iter() >= 2 &&
+           loc.iter()[0] == '[' && loc.iter()[1] == '[';
+}
+
 template<typename Value>
 result<typename Value::table_type, std::string>
 parse_ml_table(location& loc)
@@ -2280,15 +2393,21 @@ parse_ml_table(location& loc)
     {
         lex_ws::invoke(loc);
         const auto before = loc.iter();
-        if(const auto tmp = parse_array_table_key(loc)) // next table found
+        if(is_array_table_key_head(loc))
         {
-            loc.reset(before);
-            return ok(tab);
+            if(const auto tmp = parse_array_table_key(loc)) // next table found
+            {
+                loc.reset(before);
+                return ok(tab);
+            }
         }
-        if(const auto tmp = parse_table_key(loc)) // next table found
+        if(is_table_key_head(loc))
         {
-            loc.reset(before);
-            return ok(tab);
+            if(const auto tmp = parse_table_key(loc)) // next table found
+            {
+                loc.reset(before);
+                return ok(tab);
+            }
         }
 
         if(const auto kv = parse_key_value_pair<value_type>(loc, 0))
@@ -2409,22 +2528,25 @@ result<Value, std::string> parse_toml_file(location& loc)
         // the table body is normally too big and it is not so informative
         // if the first key-value pair of the table is shown in the error
         // message.
-        if(const auto tabkey = parse_array_table_key(loc))
+        if(is_array_table_key_head(loc))
         {
-            const auto tab = parse_ml_table<value_type>(loc);
-            if(!tab){return err(tab.unwrap_err());}
+            if(const auto tabkey = parse_array_table_key(loc))
+            {
+                const auto tab = parse_ml_table<value_type>(loc);
+                if(!tab){return err(tab.unwrap_err());}
 
-            const auto& tk   = tabkey.unwrap();
-            const auto& keys = tk.first;
-            const auto& reg  = tk.second;
+                const auto& tk   = tabkey.unwrap();
+                const auto& keys = tk.first;
+                const auto& reg  = tk.second;
 
-            const auto inserted = insert_nested_key(data,
-                    value_type(tab.unwrap(), reg, reg.comments()),
-                    keys.begin(), keys.end(), reg,
-                    /*is_array_of_table=*/ true);
-            if(!inserted) {return err(inserted.unwrap_err());}
+                const auto inserted = insert_nested_key(data,
+                        value_type(tab.unwrap(), reg, comments_of<value_type>(reg)),
+                        keys.begin(), keys.end(), reg,
+                        /*is_array_of_table=*/ true);
+                if(!inserted) {return err(inserted.unwrap_err());}
 
-            continue;
+                continue;
+            }
         }
         if(const auto tabkey = parse_table_key(loc))
         {
@@ -2436,7 +2558,7 @@ result<Value, std::string> parse_toml_file(location& loc)
             const auto& reg  = tk.second;
 
             const auto inserted = insert_nested_key(data,
-                value_type(tab.unwrap(), reg, reg.comments()),
+                value_type(tab.unwrap(), reg, comments_of<value_type>(reg)),
                 keys.begin(), keys.end(), reg);
             if(!inserted) {return err(inserted.unwrap_err());}
 
@@ -2455,8 +2577,6 @@ template<typename                     Comment = TOML11_DEFAULT_COMMENT_STRATEGY,
 basic_value<Comment, Table, Array>
 parse(std::vector<char>& letters, const std::string& fname)
 {
-    using value_type = basic_value<Comment, Table, Array>;
-
     // append LF.
     // Although TOML does not require LF at the EOF, to make parsing logic
     // simpler, we "normalize" the content by adding LF if it does not exist.
@@ -2468,7 +2588,18 @@ parse(std::vector<char>& letters, const std::string& fname)
         letters.push_back('\n');
     }
 
-    detail::location loc(std::move(fname), std::move(letters));
+    return parse<Comment, Table, Array>(
+            detail::location(std::move(fname), std::move(letters)));
+}
+
+// the source of `loc` must already end with a newline (see above).
+template<typename                     Comment = TOML11_DEFAULT_COMMENT_STRATEGY,
+         template<typename ...> class Table   = std::unordered_map,
+         template<typename ...> class Array   = std::vector>
+basic_value<Comment, Table, Array> parse(location loc)
+{
+    using value_type = basic_value<Comment, Table, Array>;
+    const value_arena_scope<value_type> arena_scope;
 
     // skip BOM if exists.
     // XXX component of BOM (like 0xEF) exceeds the representable range of
@@ -2496,6 +2627,70 @@ parse(std::vector<char>& letters, const std::string& fname)
     }
 }
 
+#ifdef TOML11_HAS_MMAP
+// Maps a whole file into memory so that it can be parsed in place, without
+// reading it into a vector first. Returns nullptr if the file cannot be
+// mapped (e.g. it is empty or not a regular file) so that the caller can fall
+// back to reading it.
+//
+// Like `parse(std::vector<char>&, ...)`, this makes sure that the contents end
+// with a newline. But instead of appending one to a copy of the file, one more
+// byte is reserved after the end of the mapping. That byte lies either in the
+// zero-filled tail of the last page of the file or in an anonymous page after
+// it, and the mapping is private, so the file itself is never modified.
+inline location::source_ptr map_file(const std::string& fname)
+{
+    const int fd = ::open(fname.c_str(), O_RDONLY);
+    if(fd == -1)
+    {
+        return nullptr;
+    }
+
+    struct stat st;
+    if(::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0)
+    {
+        ::close(fd);
+        return nullptr;
+    }
+    const std::size_t size      = static_cast<std::size_t>(st.st_size);
+    const std::size_t page_size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    const std::size_t reserved  = (size + page_size) / page_size * page_size;
+
+    // reserve the address range first, then map the file over its beginning.
+    void* const base = ::mmap(nullptr, reserved, PROT_READ,
+                              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(base == MAP_FAILED)
+    {
+        ::close(fd);
+        return nullptr;
+    }
+    const std::shared_ptr<const void> owner(static_cast<const void*>(base),
+        [reserved](const void* ptr) {::munmap(const_cast<void*>(ptr), reserved);});
+
+    const bool mapped = ::mmap(base, size, PROT_READ, MAP_PRIVATE | MAP_FIXED,
+                               fd, 0) != MAP_FAILED;
+    ::close(fd);
+    if(!mapped)
+    {
+        return nullptr;
+    }
+
+    char* const first = static_cast<char*>(base);
+    char*       last  = first + size;
+    if(last[-1] != '\n' && last[-1] != '\r')
+    {
+        char* const page = first + size / page_size * page_size;
+        if(::mprotect(page, page_size, PROT_READ | PROT_WRITE) != 0)
+        {
+            return nullptr;
+        }
+        *last++ = '\n';
+        ::mprotect(page, page_size, PROT_READ);
+    }
+    return std::make_shared<source_buffer>(fname, first, last, owner);
+}
+#endif // TOML11_HAS_MMAP
+
 } // detail
 
 template<typename                     Comment = TOML11_DEFAULT_COMMENT_STRATEGY,
@@ -2563,6 +2758,13 @@ template<typename                     Comment = TOML11_DEFAULT_COMMENT_STRATEGY,
          template<typename ...> class Array   = std::vector>
 basic_value<Comment, Table, Array> parse(std::string fname)
 {
+#ifdef TOML11_HAS_MMAP
+    if(auto source = detail::map_file(fname))
+    {
+        return detail::parse<Comment, Table, Array>(
+                detail::location(std::move(source)));
+    }
+#endif
     std::ifstream ifs(fname, std::ios_base::binary);
     if(!ifs.good())
     {
@@ -2573,6 +2775,131 @@ basic_value<Comment, Table, Array> parse(std::string fname)
     return parse<Comment, Table, Array>(ifs, std::move(fname));
 }
 
+namespace detail
+{
+struct offset_arena_scope;
+} // detail
+
+// offset_arena keeps where the values parsed by `parse_without_regions` were
+// in their files, in one block for all of them. Every value shares ownership
+// of the block instead of allocating a region of its own, so the values stay
+// valid after the arena is gone. It can be reused for any number of files,
+// one at a time.
+class offset_arena final : public detail::region_store
+{
+  public:
+
+    offset_arena(): block_(std::make_shared<block>()) {}
+    offset_arena(const offset_arena&) = delete;
+    offset_arena& operator=(const offset_arena&) = delete;
+    ~offset_arena() override = default;
+
+  private:
+
+    friend struct detail::offset_arena_scope;
+
+    // deque does not move its elements, so regions can point into it.
+    struct block
+    {
+        std::deque<detail::offset_source> sources;
+        std::deque<detail::offset_region> regions;
+    };
+
+    std::shared_ptr<detail::region_base> make(const detail::region& reg) override
+    {
+        assert(reg.source() == this->block_->sources.back().source);
+        this->block_->regions.emplace_back(&this->block_->sources.back(),
+                static_cast<std::size_t>(reg.first() - reg.begin()), reg.size());
+        return std::shared_ptr<detail::region_base>(
+                this->block_, &this->block_->regions.back());
+    }
+
+    std::shared_ptr<block> block_;
+};
+
+namespace detail
+{
+
+// makes the regions of `source` in `arena` while it is parsed, and lets go of
+// the source afterwards so that it is freed along with the parser.
+struct offset_arena_scope
+{
+    offset_arena_scope(offset_arena& arena, const location::source_ptr& source)
+    {
+        arena.block_->sources.push_back(offset_source{source->name(), source});
+        this->source_ = &arena.block_->sources.back();
+        source->set_store(&arena);
+    }
+    offset_arena_scope(const offset_arena_scope&) = delete;
+    offset_arena_scope& operator=(const offset_arena_scope&) = delete;
+    ~offset_arena_scope()
+    {
+        this->source_->source->set_store(nullptr);
+        this->source_->source.reset();
+    }
+
+  private:
+
+    offset_source* source_;
+};
+
+} // detail
+
+// Parses a file like `parse(fname)`, but without making a region for every
+// value. The values only remember their byte offsets, in `arena`, and the
+// contents of the file are freed as soon as parsing is done. Parsing several
+// files into one arena keeps their offsets in the same block. Syntax errors are
+// still reported with the offending line, but errors about the values
+// afterwards only show the file name and the byte offset.
+template<typename                     Comment = TOML11_DEFAULT_COMMENT_STRATEGY,
+         template<typename ...> class Table   = std::unordered_map,
+         template<typename ...> class Array   = std::vector>
+basic_value<Comment, Table, Array>
+parse_without_regions(std::string fname, offset_arena& arena)
+{
+    detail::location::source_ptr source;
+#ifdef TOML11_HAS_MMAP
+    source = detail::map_file(fname);
+#endif
+    if(!source)
+    {
+        std::ifstream ifs(fname, std::ios_base::binary);
+        if(!ifs.good())
+        {
+            throw std::ios_base::failure("toml::parse_without_regions: "
+                    "Error opening file \"" + fname + "\"");
+        }
+        ifs.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+        ifs.seekg(0, std::ios::end);
+        const auto fsize = ifs.tellg();
+        ifs.seekg(0);
+
+        std::vector<char> letters(static_cast<std::size_t>(fsize));
+        ifs.read(letters.data(), fsize);
+
+        // append LF (see `parse(std::vector<char>&, ...)`).
+        if(!letters.empty() && letters.back() != '\n' && letters.back() != '\r')
+        {
+            letters.push_back('\n');
+        }
+        source = std::make_shared<detail::source_buffer>(
+                std::move(fname), std::move(letters));
+    }
+
+    const detail::offset_arena_scope scope(arena, source);
+    return detail::parse<Comment, Table, Array>(
+            detail::location(std::move(source)));
+}
+
+template<typename                     Comment = TOML11_DEFAULT_COMMENT_STRATEGY,
+         template<typename ...> class Table   = std::unordered_map,
+         template<typename ...> class Array   = std::vector>
+basic_value<Comment, Table, Array> parse_without_regions(std::string fname)
+{
+    offset_arena arena;
+    return parse_without_regions<Comment, Table, Array>(std::move(fname), arena);
+}
+
 #ifdef TOML11_HAS_STD_FILESYSTEM
 // This function just forwards `parse("filename.toml")` to std::string version
 // to avoid the ambiguity in overload resolution.
@@ -2596,6 +2923,13 @@ template<typename                     Comment = TOML11_DEFAULT_COMMENT_STRATEGY,
          template<typename ...> class Array   = std::vector>
 basic_value<Comment, Table, Array> parse(const std::filesystem::path& fpath)
 {
+#ifdef TOML11_HAS_MMAP
+    if(auto source = detail::map_file(fpath.string()))
+    {
+        return detail::parse<Comment, Table, Array>(
+                detail::location(std::move(source)));
+    }
+#endif
     std::ifstream ifs(fpath, std::ios_base::binary);
     if(!ifs.good())
     {
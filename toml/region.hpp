@@ -5,11 +5,16 @@
 #include <memory>
 #include <vector>
 #include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <type_traits>
 #include <initializer_list>
 #include <iterator>
 #include <iomanip>
 #include <cassert>
 #include "color.hpp"
+#include "scan.hpp"
 
 namespace toml
 {
@@ -29,6 +34,161 @@ inline std::string make_string(std::size_t len, char c)
     return std::string(len, c);
 }
 
+// region_arena hands out the memory for the regions of one document. Regions
+// are small, and a document has one for every value, so allocating each of them
+// separately costs more than the values themselves. The arena allocates large
+// chunks instead and frees all of them at once when the last region is gone.
+// Memory is never reused, since regions are rarely destroyed before the
+// document they belong to. detail::value_arena (see arena.hpp) uses one for the
+// tables and arrays of toml::arena_value as well.
+//
+// Each source_buffer has its own arena, and regions are only made by the parser
+// that reads it, so one arena is never allocated from by two threads at once
+// and needs no lock. Copies of the regions can still be shared freely once the
+// parse is done.
+class region_arena
+{
+  public:
+
+    region_arena() = default;
+    region_arena(const region_arena&) = delete;
+    region_arena& operator=(const region_arena&) = delete;
+    ~region_arena() = default;
+
+    void* allocate(std::size_t size, std::size_t alignment)
+    {
+        std::size_t offset = (this->used_ + alignment - 1) / alignment * alignment;
+        if(this->chunks_.empty() || this->capacity_ < offset + size)
+        {
+            this->capacity_ = (std::max)(size + alignment,
+                this->chunks_.empty() ? 4096 : (std::min)(this->capacity_ * 2,
+                                                          std::size_t(1) << 20));
+            this->chunks_.emplace_back(new max_align_chunk[
+                (this->capacity_ + sizeof(max_align_chunk) - 1) / sizeof(max_align_chunk)]);
+            offset = 0;
+        }
+        this->used_ = offset + size;
+        return reinterpret_cast<unsigned char*>(this->chunks_.back().get()) + offset;
+    }
+
+  private:
+
+    struct alignas(std::max_align_t) max_align_chunk
+    {
+        unsigned char bytes[sizeof(std::max_align_t)];
+    };
+
+    std::vector<std::unique_ptr<max_align_chunk[]>> chunks_;
+    std::size_t                                     used_     = 0;
+    std::size_t                                     capacity_ = 0;
+};
+
+// allocates from a region_arena. The arena is shared, so that it outlives the
+// control blocks of the shared_ptrs it hands memory out for.
+template<typename T>
+struct region_allocator
+{
+    using value_type = T;
+
+    explicit region_allocator(std::shared_ptr<region_arena> arena) noexcept
+        : arena_(std::move(arena))
+    {}
+    template<typename U>
+    region_allocator(const region_allocator<U>& other) noexcept
+        : arena_(other.arena_)
+    {}
+
+    T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(this->arena_->allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T*, std::size_t) noexcept {}
+
+    template<typename U>
+    bool operator==(const region_allocator<U>& other) const noexcept
+    {
+        return this->arena_ == other.arena_;
+    }
+    template<typename U>
+    bool operator!=(const region_allocator<U>& other) const noexcept
+    {
+        return this->arena_ != other.arena_;
+    }
+
+    std::shared_ptr<region_arena> arena_;
+};
+
+struct region_base;
+struct region;
+
+// region_store makes the regions that parsed values keep. When a source has no
+// store, the regions are allocated from the arena of the source. A parse can
+// set its own store on the source to keep something smaller instead (see
+// toml::offset_arena).
+struct region_store
+{
+    virtual ~region_store() = default;
+    virtual std::shared_ptr<region_base> make(const region& reg) = 0;
+};
+
+// source_buffer holds the name and the contents of a file. It either owns the
+// contents in a vector, or refers to memory owned by something else (e.g. a
+// memory-mapped file) and keeps it alive through `owner_`. Since both are
+// contiguous, iterators are plain pointers and the parser does not need to
+// know which one it reads.
+//
+// Every region of a document refers to the same source_buffer, so it also
+// keeps the things they have in common: the name of the file, and the arena
+// the regions themselves are allocated from.
+struct source_buffer
+{
+    using const_iterator = const char*;
+
+    source_buffer(std::string name, std::vector<char> cont)
+      : name_(std::move(name)), letters_(std::move(cont)),
+        first_(letters_.data()), last_(letters_.data() + letters_.size()),
+        arena_(std::make_shared<region_arena>())
+    {}
+    source_buffer(std::string name, const char* first, const char* last,
+                  std::shared_ptr<const void> owner)
+      : name_(std::move(name)), first_(first), last_(last),
+        owner_(std::move(owner)), arena_(std::make_shared<region_arena>())
+    {}
+
+    // first_ and last_ may point into letters_, so it cannot be copied.
+    source_buffer(const source_buffer&) = delete;
+    source_buffer& operator=(const source_buffer&) = delete;
+    ~source_buffer() = default;
+
+    std::string const& name() const noexcept {return name_;}
+
+    const_iterator begin()  const noexcept {return first_;}
+    const_iterator end()    const noexcept {return last_;}
+    const_iterator cbegin() const noexcept {return first_;}
+    const_iterator cend()   const noexcept {return last_;}
+
+    const char* data()  const noexcept {return first_;}
+    std::size_t size()  const noexcept {return static_cast<std::size_t>(last_ - first_);}
+    bool        empty() const noexcept {return first_ == last_;}
+
+    std::shared_ptr<region_arena> const& arena() const noexcept {return arena_;}
+
+    // the store is set only while the source is being parsed, by the one who
+    // parses it, so it is not a part of the contents.
+    region_store* store() const noexcept {return store_;}
+    void set_store(region_store* store) const noexcept {store_ = store;}
+
+  private:
+
+    std::string                   name_;
+    std::vector<char>             letters_;
+    const char*                   first_;
+    const char*                   last_;
+    std::shared_ptr<const void>   owner_;
+    std::shared_ptr<region_arena> arena_;
+    mutable region_store*         store_ = nullptr;
+};
+
 // region_base is a base class of location and region that are defined below.
 // it will be used to generate better error messages.
 struct region_base
@@ -69,17 +229,21 @@ struct region_base
 // location.
 struct location final : public region_base
 {
-    using const_iterator  = typename std::vector<char>::const_iterator;
+    using const_iterator  = typename source_buffer::const_iterator;
     using difference_type = typename std::iterator_traits<const_iterator>::difference_type;
-    using source_ptr      = std::shared_ptr<const std::vector<char>>;
+    using source_ptr      = std::shared_ptr<const source_buffer>;
 
     location(std::string source_name, std::vector<char> cont)
-      : source_(std::make_shared<std::vector<char>>(std::move(cont))),
-        line_number_(1), source_name_(std::move(source_name)), iter_(source_->cbegin())
+      : source_(std::make_shared<source_buffer>(std::move(source_name), std::move(cont))),
+        line_number_(1), iter_(source_->cbegin())
     {}
     location(std::string source_name, const std::string& cont)
-      : source_(std::make_shared<std::vector<char>>(cont.begin(), cont.end())),
-        line_number_(1), source_name_(std::move(source_name)), iter_(source_->cbegin())
+      : source_(std::make_shared<source_buffer>(std::move(source_name),
+                    std::vector<char>(cont.begin(), cont.end()))),
+        line_number_(1), iter_(source_->cbegin())
+    {}
+    explicit location(source_ptr src)
+      : source_(std::move(src)), line_number_(1), iter_(source_->cbegin())
     {}
 
     location(const location&) = default;
@@ -91,8 +255,9 @@ struct location final : public region_base
     bool is_ok() const noexcept override {return static_cast<bool>(source_);}
     char front() const noexcept override {return *iter_;}
 
-    // this const prohibits codes like `++(loc.iter())`.
-    std::add_const<const_iterator>::type iter()  const noexcept {return iter_;}
+    // iter() returns a pointer by value, so codes like `++(loc.iter())` do not
+    // compile.
+    const_iterator iter()  const noexcept {return iter_;}
 
     const_iterator begin() const noexcept {return source_->cbegin();}
     const_iterator end()   const noexcept {return source_->cend();}
@@ -107,15 +272,13 @@ struct location final : public region_base
     // and `reset()` is added.
     void advance(difference_type n = 1) noexcept
     {
-        this->line_number_ += static_cast<std::size_t>(
-                std::count(this->iter_, std::next(this->iter_, n), '\n'));
+        this->line_number_ += count_newlines(this->iter_, this->iter_ + n);
         this->iter_ += n;
         return;
     }
     void retrace(difference_type n = 1) noexcept
     {
-        this->line_number_ -= static_cast<std::size_t>(
-                std::count(std::prev(this->iter_, n), this->iter_, '\n'));
+        this->line_number_ -= count_newlines(this->iter_ - n, this->iter_);
         this->iter_ -= n;
         return;
     }
@@ -125,25 +288,24 @@ struct location final : public region_base
         // iterators and returns a negative value if `first > last`.
         if(0 <= std::distance(rollback, this->iter_)) // rollback < iter
         {
-            this->line_number_ -= static_cast<std::size_t>(
-                    std::count(rollback, this->iter_, '\n'));
+            this->line_number_ -= count_newlines(rollback, this->iter_);
         }
         else // iter < rollback [[unlikely]]
         {
-            this->line_number_ += static_cast<std::size_t>(
-                    std::count(this->iter_, rollback, '\n'));
+            this->line_number_ += count_newlines(this->iter_, rollback);
         }
         this->iter_ = rollback;
         return;
     }
 
     std::string str()  const override {return make_string(1, *this->iter());}
-    std::string name() const override {return source_name_;}
+    std::string name() const override {return source_->name();}
 
     std::string line_num() const override
     {
         return std::to_string(this->line_number_);
     }
+    std::size_t line_number() const noexcept {return this->line_number_;}
 
     std::string line() const override
     {
@@ -186,7 +348,6 @@ struct location final : public region_base
 
     source_ptr     source_;
     std::size_t    line_number_;
-    std::string    source_name_;
     const_iterator iter_;
 };
 
@@ -196,26 +357,28 @@ struct location final : public region_base
 // and last location.
 struct region final : public region_base
 {
-    using const_iterator = typename std::vector<char>::const_iterator;
-    using source_ptr     = std::shared_ptr<const std::vector<char>>;
+    using const_iterator = typename source_buffer::const_iterator;
+    using source_ptr     = std::shared_ptr<const source_buffer>;
 
     // delete default constructor. source_ never be null.
     region() = delete;
 
     explicit region(const location& loc)
-      : source_(loc.source()), source_name_(loc.name()),
-        first_(loc.iter()), last_(loc.iter())
+      : source_(loc.source()), first_(loc.iter()), last_(loc.iter()),
+        line_number_(loc.line_number())
     {}
     explicit region(location&& loc)
-      : source_(loc.source()), source_name_(loc.name()),
-        first_(loc.iter()), last_(loc.iter())
+      : source_(loc.source()), first_(loc.iter()), last_(loc.iter()),
+        line_number_(loc.line_number())
     {}
 
     region(const location& loc, const_iterator f, const_iterator l)
-      : source_(loc.source()), source_name_(loc.name()), first_(f), last_(l)
+      : source_(loc.source()), first_(f), last_(l),
+        line_number_(line_number_at(loc, f))
     {}
     region(location&& loc, const_iterator f, const_iterator l)
-      : source_(loc.source()), source_name_(loc.name()), first_(f), last_(l)
+      : source_(loc.source()), first_(f), last_(l),
+        line_number_(line_number_at(loc, f))
     {}
 
     region(const region&) = default;
@@ -248,7 +411,7 @@ struct region final : public region_base
     }
     std::string line_num() const override
     {
-        return std::to_string(1 + std::count(this->begin(), this->first(), '\n'));
+        return std::to_string(this->line_number_);
     }
 
     std::size_t size() const noexcept override
@@ -294,7 +457,7 @@ struct region final : public region_base
     source_ptr const& source() const& noexcept {return source_;}
     source_ptr&&      source() &&     noexcept {return std::move(source_);}
 
-    std::string name() const override {return source_name_;}
+    std::string name() const override {return source_->name();}
 
     std::vector<std::string> comments() const override
     {
@@ -406,11 +569,107 @@ struct region final : public region_base
 
   private:
 
+    // a region is usually made just after its range has been lexed, so `f` is
+    // close to the location. counting newlines from the beginning of the file
+    // every time line_num() is called makes source_location quadratic.
+    static std::size_t line_number_at(const location& loc, const_iterator f) noexcept
+    {
+        if(f <= loc.iter())
+        {
+            return loc.line_number() - count_newlines(f, loc.iter());
+        }
+        return loc.line_number() + count_newlines(loc.iter(), f);
+    }
+
     source_ptr     source_;
-    std::string    source_name_;
     const_iterator first_, last_;
+    std::size_t    line_number_;
+};
+
+// offset_source is the file that offset_regions refer to. `source` is set only
+// while the file is being parsed. Both live in the block of a toml::offset_arena
+// that every value parsed into it shares.
+struct offset_source
+{
+    std::string          name;
+    location::source_ptr source;
+};
+
+// offset_region remembers only where a value was in its file (see
+// toml::parse_without_regions). While the file is being parsed, it reads the
+// file like a region does. Afterwards the file is gone, so it has no line or
+// text to show, and error messages point to the byte offset instead.
+struct offset_region final : public region_base
+{
+    offset_region(const offset_source* src, std::size_t offset,
+                  std::size_t size) noexcept
+        : source_(src), offset_(offset), size_(size)
+    {}
+
+    bool is_ok() const noexcept override
+    {
+        return static_cast<bool>(source_->source);
+    }
+    char front() const noexcept override
+    {
+        return this->is_ok() ? source_->source->data()[offset_] : '\0';
+    }
+
+    std::string str() const override
+    {
+        if(!this->is_ok()) {return std::string("");}
+        const char* const first = source_->source->data() + offset_;
+        return make_string(first, first + size_);
+    }
+    std::string name() const override {return source_->name;}
+    std::string line() const override
+    {
+        return this->is_ok() ? this->live().line() : std::string("");
+    }
+    std::string line_num() const override
+    {
+        return this->is_ok() ? this->live().line_num() : region_base::line_num();
+    }
+
+    std::size_t size()   const noexcept override {return size_;}
+    std::size_t before() const noexcept override
+    {
+        return this->is_ok() ? this->live().before() : 0;
+    }
+    std::size_t after()  const noexcept override
+    {
+        return this->is_ok() ? this->live().after() : 0;
+    }
+
+    std::size_t offset() const noexcept {return offset_;}
+
+  private:
+
+    // counts the lines from the beginning of the file, which is slow, but
+    // this is only needed for error messages.
+    region live() const
+    {
+        const location loc(source_->source);
+        return region(loc, loc.begin() + offset_, loc.begin() + offset_ + size_);
+    }
+
+    const offset_source* source_;
+    std::size_t          offset_;
+    std::size_t          size_;
 };
 
+// regions are allocated from the arena of their source, so that parsing a
+// document does not allocate every one of them separately.
+inline std::shared_ptr<region_base> make_region(region reg)
+{
+    if(region_store* store = reg.source()->store())
+    {
+        return store->make(reg);
+    }
+    const region_allocator<region> alloc(reg.source()->arena());
+    return std::allocate_shared<region>(alloc, std::move(reg));
+}
+
 } // detail
 } // toml
 #endif// TOML11_REGION_H
@@ -0,0 +1,193 @@
+// Distributed under the MIT License.
+#ifndef TOML11_SCAN_HPP
+#define TOML11_SCAN_HPP
+#include <algorithm>
+#include <cstddef>
+
+#ifndef TOML11_DISABLE_SIMD
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TOML11_HAS_SSE2
+#include <emmintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif // sse2
+#endif // TOML11_DISABLE_SIMD
+
+// byte-level scanners used by the lexer to skip long runs of characters that
+// need no further inspection (whitespace, comment bodies, string bodies) in one
+// go, instead of one combinator call per character. with SSE2 they look at 16
+// bytes at a time.
+
+namespace toml
+{
+namespace detail
+{
+
+#ifdef TOML11_HAS_SSE2
+inline unsigned count_trailing_zeros(const unsigned x) noexcept
+{
+    // x is never zero here.
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long idx = 0;
+    _BitScanForward(&idx, x);
+    return static_cast<unsigned>(idx);
+#else
+    return static_cast<unsigned>(__builtin_ctz(x));
+#endif
+}
+#endif
+
+// returns the number of '\n' in [first, last). location uses this to keep its
+// line number in sync when it moves over a long range.
+inline std::size_t count_newlines(const char* first, const char* last) noexcept
+{
+    std::size_t count = 0;
+#ifdef TOML11_HAS_SSE2
+    const __m128i newline = _mm_set1_epi8('\n');
+    while(last - first >= 16)
+    {
+        // each byte lane counts up to 255 newlines before it overflows, so
+        // the lanes are summed up every 255 blocks.
+        const std::ptrdiff_t blocks = (std::min)((last - first) / 16,
+                                                 std::ptrdiff_t(255));
+        const char* const block_last = first + blocks * 16;
+
+        __m128i lanes = _mm_setzero_si128();
+        for(; first != block_last; first += 16)
+        {
+            const __m128i x = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i*>(first));
+            lanes = _mm_sub_epi8(lanes, _mm_cmpeq_epi8(x, newline));
+        }
+        const __m128i sums = _mm_sad_epu8(lanes, _mm_setzero_si128());
+        count += static_cast<std::size_t>(_mm_cvtsi128_si32(sums)) +
+                 static_cast<std::size_t>(_mm_extract_epi16(sums, 4));
+    }
+#endif
+    return count + static_cast<std::size_t>(std::count(first, last, '\n'));
+}
+
+// returns the first character in [first, last) that is not in `CharClass`.
+// a CharClass has `static bool match(unsigned char)` and, if SSE2 is
+// available, `static __m128i match(__m128i)` that sets every byte of the
+// result whose input is in the class to 0xFF.
+template<typename CharClass>
+const char* scan_while(const char* first, const char* last) noexcept
+{
+#ifdef TOML11_HAS_SSE2
+    while(last - first >= 16)
+    {
+        const __m128i x = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(first));
+        const unsigned rest = ~static_cast<unsigned>(
+                _mm_movemask_epi8(CharClass::match(x))) & 0xFFFFu;
+        if(rest != 0)
+        {
+            return first + count_trailing_zeros(rest);
+        }
+        first += 16;
+    }
+#endif
+    while(first != last && CharClass::match(static_cast<unsigned char>(*first)))
+    {
+        ++first;
+    }
+    return first;
+}
+
+// ' ' and '\t'. see lex_wschar.
+struct whitespace_chars
+{
+    static bool match(const unsigned char c) noexcept
+    {
+        return c == ' ' || c == '\t';
+    }
+#ifdef TOML11_HAS_SSE2
+    static __m128i match(const __m128i x) noexcept
+    {
+        return _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(' ')),
+                            _mm_cmpeq_epi8(x, _mm_set1_epi8('\t')));
+    }
+#endif
+};
+
+// whitespace and '\n'. a "\r\n" is left to lex_newline.
+struct whitespace_newline_chars
+{
+    static bool match(const unsigned char c) noexcept
+    {
+        return whitespace_chars::match(c) || c == '\n';
+    }
+#ifdef TOML11_HAS_SSE2
+    static __m128i match(const __m128i x) noexcept
+    {
+        return _mm_or_si128(whitespace_chars::match(x),
+                            _mm_cmpeq_epi8(x, _mm_set1_epi8('\n')));
+    }
+#endif
+};
+
+// '\t' and 0x20-0x7E. see lex_non_eol_ascii. non-ascii characters are left to
+// the utf-8 lexers.
+struct non_eol_ascii_chars
+{
+    static bool match(const unsigned char c) noexcept
+    {
+        return c == '\t' || (0x20 <= c && c <= 0x7E);
+    }
+#ifdef TOML11_HAS_SSE2
+    static __m128i match(const __m128i x) noexcept
+    {
+        // the comparison is signed, so bytes larger than 0x7F are negative.
+        const __m128i printable = _mm_andnot_si128(
+                _mm_cmpeq_epi8(x, _mm_set1_epi8(0x7F)),
+                _mm_cmpgt_epi8(x, _mm_set1_epi8(0x1F)));
+        return _mm_or_si128(printable, _mm_cmpeq_epi8(x, _mm_set1_epi8('\t')));
+    }
+#endif
+};
+
+// characters that may appear unescaped in a basic string. see
+// lex_basic_unescaped. the validity of utf-8 sequences is checked by the
+// parser after lexing, so every non-ascii byte is accepted here.
+struct basic_unescaped_chars
+{
+    static bool match(const unsigned char c) noexcept
+    {
+        return (non_eol_ascii_chars::match(c) && c != '"' && c != '\\') ||
+               0x80 <= c;
+    }
+#ifdef TOML11_HAS_SSE2
+    static __m128i match(const __m128i x) noexcept
+    {
+        const __m128i special = _mm_or_si128(
+                _mm_cmpeq_epi8(x, _mm_set1_epi8('"')),
+                _mm_cmpeq_epi8(x, _mm_set1_epi8('\\')));
+        return _mm_or_si128(
+                _mm_andnot_si128(special, non_eol_ascii_chars::match(x)),
+                _mm_cmplt_epi8(x, _mm_setzero_si128()));
+    }
+#endif
+};
+
+// the body of a multi-line basic string. the same as above, plus '\n'. a `"`
+// is left to the lexer because it may be a part of the closing delimiter.
+struct ml_basic_unescaped_chars
+{
+    static bool match(const unsigned char c) noexcept
+    {
+        return basic_unescaped_chars::match(c) || c == '\n';
+    }
+#ifdef TOML11_HAS_SSE2
+    static __m128i match(const __m128i x) noexcept
+    {
+        return _mm_or_si128(basic_unescaped_chars::match(x),
+                            _mm_cmpeq_epi8(x, _mm_set1_epi8('\n')));
+    }
+#endif
+};
+
+} // detail
+} // toml
+#endif// TOML11_SCAN_HPP
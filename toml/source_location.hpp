@@ -35,6 +35,12 @@ namespace toml
 // - std::string const& line_str() const noexcept;
 //   - the whole line that contains the region of interest.
 //
+// - bool has_byte_offset() const noexcept;
+// - std::size_t byte_offset() const noexcept;
+//   - for values parsed by toml::parse_without_regions, the source is gone.
+//     they have no line, and only the byte offset from the beginning of the
+//     file is known.
+//
 struct source_location
 {
   public:
@@ -59,6 +65,13 @@ struct source_location
             region_size_ = static_cast<std::uint_least32_t>(reg->size());
             file_name_   = reg->name();
             line_str_    = reg->line();
+
+            const auto* off = dynamic_cast<const detail::offset_region*>(reg);
+            if(off && !off->is_ok())
+            {
+                has_byte_offset_ = true;
+                byte_offset_     = off->offset();
+            }
         }
     }
 
@@ -90,6 +103,9 @@ struct source_location
     std::string const&  file_name() const noexcept {return file_name_;}
     std::string const&  line_str()  const noexcept {return line_str_;}
 
+    bool        has_byte_offset() const noexcept {return has_byte_offset_;}
+    std::size_t byte_offset()     const noexcept {return byte_offset_;}
+
   private:
 
     std::uint_least32_t line_num_;
@@ -97,6 +113,8 @@ struct source_location
     std::uint_least32_t region_size_;
     std::string         file_name_;
     std::string         line_str_;
+    bool                has_byte_offset_ = false;
+    std::size_t         byte_offset_     = 0;
 };
 
 namespace detail
@@ -111,6 +129,7 @@ inline std::string format_underline(const std::string& message,
     std::size_t line_num_width = 0;
     for(const auto& lc : loc_com)
     {
+        if(lc.first.has_byte_offset()) {continue;} // no line number to show
         std::uint_least32_t line = lc.first.line();
         std::size_t        digit = 0;
         while(line != 0)
@@ -156,6 +175,16 @@ inline std::string format_underline(const std::string& message,
         (std::ostringstream& oss,
          const source_location& loc, const std::string& comment) -> void
         {
+            if(loc.has_byte_offset())
+            {
+                // the line is not known, only the byte offset.
+                //   | byte 42: comment
+                oss << make_string(line_num_width + 1, ' ')
+                    << color::bold << color::blue << " | " << color::reset
+                    << "byte " << loc.byte_offset() << ": " << comment;
+                return;
+            }
+
             oss << ' ' << color::bold << color::blue
                 << std::setw(static_cast<int>(line_num_width))
                 << std::right << loc.line() << " | "  << color::reset
@@ -2,6 +2,7 @@
 // Distributed under the MIT License.
 #ifndef TOML11_STORAGE_HPP
 #define TOML11_STORAGE_HPP
+#include <memory>
 #include "utility.hpp"
 
 namespace toml
@@ -9,33 +10,108 @@ namespace toml
 namespace detail
 {
 
+// storage allocates its content with the allocator of the content, if it has
+// one, so that a table or an array and the storage that holds it come from the
+// same place (see toml::arena_allocator). Otherwise it uses std::allocator.
+template<typename T, typename = void>
+struct storage_allocator
+{
+    using type = std::allocator<T>;
+    static type select(const T&) noexcept {return type();}
+};
+template<typename T>
+struct storage_allocator<T, typename std::conditional<false,
+    decltype(std::declval<const T&>().get_allocator()), void>::type>
+{
+    using type = typename std::allocator_traits<typename T::allocator_type
+        >::template rebind_alloc<T>;
+    static type select(const T& v) {return type(v.get_allocator());}
+};
+
 // this contains pointer and deep-copy the content if copied.
 // to avoid recursive pointer.
 template<typename T>
 struct storage
 {
-    using value_type = T;
+    using value_type     = T;
+    using allocator_type = typename storage_allocator<T>::type;
+    using traits         = std::allocator_traits<allocator_type>;
 
-    explicit storage(value_type const& v): ptr(toml::make_unique<T>(v)) {}
-    explicit storage(value_type&&      v): ptr(toml::make_unique<T>(std::move(v))) {}
-    ~storage() = default;
-    storage(const storage& rhs): ptr(toml::make_unique<T>(*rhs.ptr)) {}
+    // a copy is allocated like its containers allocate copies of themselves,
+    // and a moved content stays with the allocator it was made with.
+    explicit storage(value_type const& v)
+        : alloc_(traits::select_on_container_copy_construction(
+                 storage_allocator<T>::select(v))),
+          ptr(this->make(v))
+    {}
+    explicit storage(value_type&& v)
+        : alloc_(storage_allocator<T>::select(v)), ptr(this->make(std::move(v)))
+    {}
+    ~storage() {this->destroy();}
+    storage(const storage& rhs)
+        : alloc_(traits::select_on_container_copy_construction(rhs.alloc_)),
+          ptr(this->make(*rhs.ptr))
+    {}
     storage& operator=(const storage& rhs)
     {
-        this->ptr = toml::make_unique<T>(*rhs.ptr);
+        if(this != &rhs)
+        {
+            storage tmp(rhs);
+            this->swap(tmp);
+        }
+        return *this;
+    }
+    storage(storage&& rhs) noexcept
+        : alloc_(std::move(rhs.alloc_)), ptr(rhs.ptr)
+    {
+        rhs.ptr = nullptr;
+    }
+    storage& operator=(storage&& rhs) noexcept
+    {
+        this->swap(rhs);
         return *this;
     }
-    storage(storage&&) = default;
-    storage& operator=(storage&&) = default;
 
-    bool is_ok() const noexcept {return static_cast<bool>(ptr);}
+    bool is_ok() const noexcept {return ptr != nullptr;}
 
     value_type&       value() &      noexcept {return *ptr;}
     value_type const& value() const& noexcept {return *ptr;}
     value_type&&      value() &&     noexcept {return std::move(*ptr);}
 
   private:
-    std::unique_ptr<value_type> ptr;
+
+    template<typename U>
+    value_type* make(U&& v)
+    {
+        value_type* p = traits::allocate(this->alloc_, 1);
+        try
+        {
+            traits::construct(this->alloc_, p, std::forward<U>(v));
+        }
+        catch(...)
+        {
+            traits::deallocate(this->alloc_, p, 1);
+            throw;
+        }
+        return p;
+    }
+    void destroy() noexcept
+    {
+        if(this->ptr)
+        {
+            traits::destroy(this->alloc_, this->ptr);
+            traits::deallocate(this->alloc_, this->ptr, 1);
+        }
+    }
+    void swap(storage& rhs) noexcept
+    {
+        using std::swap;
+        swap(this->alloc_, rhs.alloc_);
+        swap(this->ptr,    rhs.ptr);
+    }
+
+    allocator_type alloc_;
+    value_type*    ptr;
 };
 
 } // detail
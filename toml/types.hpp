@@ -7,6 +7,7 @@
 
 #include "comments.hpp"
 #include "datetime.hpp"
+#include "flat_map.hpp"
 #include "string.hpp"
 #include "traits.hpp"
 
@@ -30,10 +30,21 @@ inline region_base const* get_region(const Value& v)
 template<typename Value>
 void change_region(Value& v, region reg)
 {
-    v.region_info_ = std::make_shared<region>(std::move(reg));
+    v.region_info_ = make_region(std::move(reg));
     return;
 }
 
+// Values that were not parsed from a file all share one empty region. It is
+// held through an aliasing shared_ptr without an owner, so handing it out does
+// not allocate and copying it does not touch a reference count.
+inline std::shared_ptr<region_base> const& no_region() noexcept
+{
+    static region_base empty;
+    static const std::shared_ptr<region_base> ptr(
+            std::shared_ptr<region_base>(), &empty);
+    return ptr;
+}
+
 template<value_t Expected, typename Value>
 [[noreturn]] inline void
 throw_bad_cast(const std::string& funcname, value_t actual, const Value& v)
@@ -69,7 +80,12 @@ throw_key_not_found_error(const Value& v, const key& ky)
     // message should explicitly say "key not found in the top-level table",
     // or "the parsed file is empty" if there is no content at all (0 bytes in file).
     const auto loc = v.location();
-    if(loc.line() == 1 && loc.region() == 0)
+
+    // Values parsed by `parse_without_regions` have no line numbers, but the
+    // top-level table still starts at the first byte of the file.
+    const bool first_line = loc.has_byte_offset() ? loc.byte_offset() == 0 :
+                                                    loc.line() == 1;
+    if(first_line && loc.region() == 0)
     {
         // First line with a zero-length region means "empty file".
         // The region will be generated at `parse_toml_file` function
@@ -79,7 +95,7 @@ throw_key_not_found_error(const Value& v, const key& ky)
                 {loc, "the parsed file is empty"}
             }));
     }
-    else if(loc.line() == 1 && loc.region() == 1)
+    else if(first_line && loc.region() == 1)
     {
         // Here it assumes that top-level table starts at the first character.
         // The region corresponds to the top-level table will be generated at
@@ -204,7 +220,7 @@ class basic_value
 
     basic_value() noexcept
         : type_(value_t::empty),
-          region_info_(std::make_shared<region_base>(region_base{}))
+          region_info_(detail::no_region())
     {}
     ~basic_value() noexcept {this->cleanup();}
 
@@ -444,7 +460,7 @@ class basic_value
 
     basic_value(boolean b)
         : type_(value_t::boolean),
-          region_info_(std::make_shared<region_base>(region_base{}))
+          region_info_(detail::no_region())
     {
         assigner(this->boolean_, b);
     }
@@ -452,13 +468,13 @@ class basic_value
     {
         this->cleanup();
         this->type_ = value_t::boolean;
-        this->region_info_ = std::make_shared<region_base>(region_base{});
+        this->region_info_ = detail::no_region();
         assigner(this->boolean_, b);
         return *this;
     }
     basic_value(boolean b, std::vector<std::string> com)
         : type_(value_t::boolean),
-          region_info_(std::make_shared<region_base>(region_base{})),
+          region_info_(detail::no_region()),
           comments_(std::move(com))
     {
         assigner(this->boolean_, b);
@@ -471,7 +487,7 @@ class basic_value
         std::nullptr_t>::type = nullptr>
     basic_value(T i)
         : type_(value_t::integer),
-          region_info_(std::make_shared<region_base>(region_base{}))
+          region_info_(detail::no_region())
     {
         assigner(this->integer_, static_cast<integer>(i));
     }
@@ -483,7 +499,7 @@ class basic_value
     {
         this->cleanup();
         this->type_ = value_t::integer;
-        this->region_info_ = std::make_shared<region_base>(region_base{});
+        this->region_info_ = detail::no_region();
         assigner(this->integer_, static_cast<integer>(i));
         return *this;
     }
@@ -493,7 +509,7 @@ class basic_value
         std::nullptr_t>::type = nullptr>
     basic_value(T i, std::vector<std::string> com)
         : type_(value_t::integer),
-          region_info_(std::make_shared<region_base>(region_base{})),
+          region_info_(detail::no_region()),
           comments_(std::move(com))
     {
         assigner(this->integer_, static_cast<integer>(i));
@@ -505,7 +521,7 @@ class basic_value
         std::is_floating_point<T>::value, std::nullptr_t>::type = nullptr>
     basic_value(T f)
         : type_(value_t::floating),
-          region_info_(std::make_shared<region_base>(region_base{}))
+          region_info_(detail::no_region())
     {
         assigner(this->floating_, static_cast<floating>(f));
     }
@@ -517,7 +533,7 @@ class basic_value
     {
         this->cleanup();
         this->type_ = value_t::floating;
-        this->region_info_ = std::make_shared<region_base>(region_base{});
+        this->region_info_ = detail::no_region();
         assigner(this->floating_, static_cast<floating>(f));
         return *this;
     }
@@ -526,7 +542,7 @@ class basic_value
         std::is_floating_point<T>::value, std::nullptr_t>::type = nullptr>
     basic_value(T f, std::vector<std::string> com)
         : type_(value_t::floating),
-          region_info_(std::make_shared<region_base>(region_base{})),
+          region_info_(detail::no_region()),
           comments_(std::move(com))
     {
         assigner(this->floating_, f);
@@ -536,7 +552,7 @@ class basic_value
 
     basic_value(toml::string s)
         : type_(value_t::string),
-          region_info_(std::make_shared<region_base>(region_base{}))
+          region_info_(detail::no_region())
     {
         assigner(this->string_, std::move(s));
     }
@@ -544,13 +560,13 @@ class basic_value
     {
         this->cleanup();
         this->type_ = value_t::string ;
-        this->region_info_ = std::make_shared<region_base>(region_base{});
+        this->region_info_ = detail::no_region();
         assigner(this->string_, s);
         return *this;
     }
     basic_value(toml::string s, std::vector<std::string> com)
         : type_(value_t::string),
-          region_info_(std::make_shared<region_base>(region_base{})),
+          region_info_(detail::no_region()),
           comments_(std::move(com))
     {
         assigner(this->string_, std::move(s));
@@ -558,7 +574,7 @@ class basic_value
 
     basic_value(std::string s)
         : type_(value_t::string),
-          region_info_(std::make_shared<region_base>(region_base{}))
+          region_info_(detail::no_region())
     {
         assigner(this->string_, toml::string(std::move(s)));
     }
@@ -566,26 +582,26 @@ class basic_value
     {
         this->cleanup();
         this->type_ = value_t::string ;
-        this->region_info_ = std::make_shared<region_base>(region_base{});
+        this->region_info_ = detail::no_region();
         assigner(this->string_, toml::string(std::move(s)));
         return *this;
     }
     basic_value(std::string s, string_t kind)
         : type_(value_t::string),
-          region_info_(std::make_shared<region_base>(region_base{}))
+          region_info_(detail::no_region())
     {
         assigner(this->string_, toml::string(std::move(s), kind));
     }
     basic_value(std::string s, std::vector<std::string> com)
         : type_(value_t::string),
-          region_info_(std::make_shared<region_base>(region_base{})),
+          region_info_(detail::no_region()),
           comments_(std::move(com))
     {
         assigner(this->string_, toml::string(std::move(s)));
     }
     basic_value(std::string s, string_t kind, std::vector<std::string> com)
         : type_(value_t::string),
-          region_info_(std::make_shared<region_base>(region_base{})),
+          region_info_(detail::no_region()),
           comments_(std::move(com))
     {
         assigner(this->string_, toml::string(std::move(s), kind));
@@ -593,7 +609,7 @@ class basic_value
 
     basic_value(const char* s)
         : type_(value_t::string),
-          region_info_(std::make_shared<region_base>(region_base{}))
+          region_info_(detail::no_region())
     {
         assigner(this->string_, toml::string(std::string(s)));
     }
@@ -601,26 +617,26 @@ class basic_value
     {
         this->cleanup();
         this->type_ = value_t::string ;
-        this->region_info_ = std::make_shared<region_base>(region_base{});
+        this->region_info_ = detail::no_region();
         assigner(this->string_, toml::string(std::string(s)));
         return *this;
     }
     basic_value(const char* s, string_t kind)
         : type_(value_t::string),
-          region_info_(std::make_shared<region_base>(region_base{}))
+          region_info_(detail::no_region())
     {
         assigner(this->string_, toml::string(std::string(s), kind));
     }
     basic_value(const char* s, std::vector<std::string> com)
         : type_(value_t::string),
-          region_info_(std::make_shared<region_base>(region_base{})),
+          region_info_(detail::no_region()),
           comments_(std::move(com))
     {
         assigner(this->string_, toml::string(std::string(s)));
     }
     basic_value(const char* s, string_t kind, std::vector<std::string> com)
         : type_(value_t::string),
-          region_info_(std::make_shared<region_base>(region_base{})),
+          region_info_(detail::no_region()),
           comments_(std::move(com))
     {
         assigner(this->string_, toml::string(std::string(s), kind));
@@ -629,7 +645,7 @@ class basic_value
 #if defined(TOML11_USING_STRING_VIEW) && TOML11_USING_STRING_VIEW>0
     basic_value(std::string_view s)
         : type_(value_t::string),
-          region_info_(std::make_shared<region_base>(region_base{}))
+          region_info_(detail::no_region())
     {
         assigner(this->string_, toml::string(s));
     }
@@ -637,26 +653,26 @@ class basic_value
     {
         this->cleanup();
         this->type_ = value_t::string ;
-        this->region_info_ = std::make_shared<region_base>(region_base{});
+        this->region_info_ = detail::no_region();
         assigner(this->string_, toml::string(s));
         return *this;
     }
     basic_value(std::string_view s, std::vector<std::string> com)
         : type_(value_t::string),
-          region_info_(std::make_shared<region_base>(region_base{})),
+          region_info_(detail::no_region()),
           comments_(std::move(com))
     {
         assigner(this->string_, toml::string(s));
     }
     basic_value(std::string_view s, string_t kind)
         : type_(value_t::string),
-          region_info_(std::make_shared<region_base>(region_base{}))
+          region_info_(detail::no_region())
     {
         assigner(this->string_, toml::string(s, kind));
     }
     basic_value(std::string_view s, string_t kind, std::vector<std::string> com)
         : type_(value_t::string),
-          region_info_(std::make_shared<region_base>(region_base{})),
+          region_info_(detail::no_region()),
           comments_(std::move(com))
     {
         assigner(this->string_, toml::string(s, kind));
@@ -667,7 +683,7 @@ class basic_value
 
     basic_value(const local_date& ld)
         : type_(value_t::local_date),
-          region_info_(std::make_shared<region_base>(region_base{}))
+          region_info_(detail::no_region())
     {
         assigner(this->local_date_, ld);
     }
@@ -675,13 +691,13 @@ class basic_value
     {
         this->cleanup();
         this->type_ = value_t::local_date;
-        this->region_info_ = std::make_shared<region_base>(region_base{});
+        this->region_info_ = detail::no_region();
         assigner(this->local_date_, ld);
         return *this;
     }
     basic_value(const local_date& ld, std::vector<std::string> com)
         : type_(value_t::local_date),
-          region_info_(std::make_shared<region_base>(region_base{})),
+          region_info_(detail::no_region()),
           comments_(std::move(com))
     {
         assigner(this->local_date_, ld);
@@ -691,13 +707,13 @@ class basic_value
 
     basic_value(const local_time& lt)
         : type_(value_t::local_time),
-          region_info_(std::make_shared<region_base>(region_base{}))
+          region_info_(detail::no_region())
     {
         assigner(this->local_time_, lt);
     }
     basic_value(const local_time& lt, std::vector<std::string> com)
         : type_(value_t::local_time),
-          region_info_(std::make_shared<region_base>(region_base{})),
+          region_info_(detail::no_region()),
           comments_(std::move(com))
     {
         assigner(this->local_time_, lt);
@@ -706,7 +722,7 @@ class basic_value
     {
         this->cleanup();
         this->type_ = value_t::local_time;
-        this->region_info_ = std::make_shared<region_base>(region_base{});
+        this->region_info_ = detail::no_region();
         assigner(this->local_time_, lt);
         return *this;
     }
@@ -714,7 +730,7 @@ class basic_value
     template<typename Rep, typename Period>
     basic_value(const std::chrono::duration<Rep, Period>& dur)
         : type_(value_t::local_time),
-          region_info_(std::make_shared<region_base>(region_base{}))
+          region_info_(detail::no_region())
     {
         assigner(this->local_time_, local_time(dur));
     }
@@ -722,7 +738,7 @@ class basic_value
     basic_value(const std::chrono::duration<Rep, Period>& dur,
                 std::vector<std::string> com)
         : type_(value_t::local_time),
-          region_info_(std::make_shared<region_base>(region_base{})),
+          region_info_(detail::no_region()),
           comments_(std::move(com))
     {
         assigner(this->local_time_, local_time(dur));
@@ -732,7 +748,7 @@ class basic_value
     {
         this->cleanup();
         this->type_ = value_t::local_time;
-        this->region_info_ = std::make_shared<region_base>(region_base{});
+        this->region_info_ = detail::no_region();
         assigner(this->local_time_, local_time(dur));
         return *this;
     }
@@ -741,13 +757,13 @@ class basic_value
 
     basic_value(const local_datetime& ldt)
         : type_(value_t::local_datetime),
-          region_info_(std::make_shared<region_base>(region_base{}))
+          region_info_(detail::no_region())
     {
         assigner(this->local_datetime_, ldt);
     }
     basic_value(const local_datetime& ldt, std::vector<std::string> com)
         : type_(value_t::local_datetime),
-          region_info_(std::make_shared<region_base>(region_base{})),
+          region_info_(detail::no_region()),
           comments_(std::move(com))
     {
         assigner(this->local_datetime_, ldt);
@@ -756,7 +772,7 @@ class basic_value
     {
         this->cleanup();
         this->type_ = value_t::local_datetime;
-        this->region_info_ = std::make_shared<region_base>(region_base{});
+        this->region_info_ = detail::no_region();
         assigner(this->local_datetime_, ldt);
         return *this;
     }
@@ -765,13 +781,13 @@ class basic_value
 
     basic_value(const offset_datetime& odt)
         : type_(value_t::offset_datetime),
-          region_info_(std::make_shared<region_base>(region_base{}))
+          region_info_(detail::no_region())
     {
         assigner(this->offset_datetime_, odt);
     }
     basic_value(const offset_datetime& odt, std::vector<std::string> com)
         : type_(value_t::offset_datetime),
-          region_info_(std::make_shared<region_base>(region_base{})),
+          region_info_(detail::no_region()),
           comments_(std::move(com))
     {
         assigner(this->offset_datetime_, odt);
@@ -780,20 +796,20 @@ class basic_value
     {
         this->cleanup();
         this->type_ = value_t::offset_datetime;
-        this->region_info_ = std::make_shared<region_base>(region_base{});
+        this->region_info_ = detail::no_region();
         assigner(this->offset_datetime_, odt);
         return *this;
     }
     basic_value(const std::chrono::system_clock::time_point& tp)
         : type_(value_t::offset_datetime),
-          region_info_(std::make_shared<region_base>(region_base{}))
+          region_info_(detail::no_region())
     {
         assigner(this->offset_datetime_, offset_datetime(tp));
     }
     basic_value(const std::chrono::system_clock::time_point& tp,
                 std::vector<std::string> com)
         : type_(value_t::offset_datetime),
-          region_info_(std::make_shared<region_base>(region_base{})),
+          region_info_(detail::no_region()),
           comments_(std::move(com))
     {
         assigner(this->offset_datetime_, offset_datetime(tp));
@@ -802,7 +818,7 @@ class basic_value
     {
         this->cleanup();
         this->type_ = value_t::offset_datetime;
-        this->region_info_ = std::make_shared<region_base>(region_base{});
+        this->region_info_ = detail::no_region();
         assigner(this->offset_datetime_, offset_datetime(tp));
         return *this;
     }
@@ -811,13 +827,13 @@ class basic_value
 
     basic_value(const array_type& ary)
         : type_(value_t::array),
-          region_info_(std::make_shared<region_base>(region_base{}))
+          region_info_(detail::no_region())
     {
         assigner(this->array_, ary);
     }
     basic_value(const array_type& ary, std::vector<std::string> com)
         : type_(value_t::array),
-          region_info_(std::make_shared<region_base>(region_base{})),
+          region_info_(detail::no_region()),
           comments_(std::move(com))
     {
         assigner(this->array_, ary);
@@ -826,7 +842,7 @@ class basic_value
     {
         this->cleanup();
         this->type_ = value_t::array ;
-        this->region_info_ = std::make_shared<region_base>(region_base{});
+        this->region_info_ = detail::no_region();
         assigner(this->array_, ary);
         return *this;
     }
@@ -838,7 +854,7 @@ class basic_value
         std::nullptr_t>::type = nullptr>
     basic_value(std::initializer_list<T> list)
         : type_(value_t::array),
-          region_info_(std::make_shared<region_base>(region_base{}))
+          region_info_(detail::no_region())
     {
         array_type ary(list.begin(), list.end());
         assigner(this->array_, std::move(ary));
@@ -848,7 +864,7 @@ class basic_value
         std::nullptr_t>::type = nullptr>
     basic_value(std::initializer_list<T> list, std::vector<std::string> com)
         : type_(value_t::array),
-          region_info_(std::make_shared<region_base>(region_base{})),
+          region_info_(detail::no_region()),
           comments_(std::move(com))
     {
         array_type ary(list.begin(), list.end());
@@ -861,7 +877,7 @@ class basic_value
     {
         this->cleanup();
         this->type_ = value_t::array;
-        this->region_info_ = std::make_shared<region_base>(region_base{});
+        this->region_info_ = detail::no_region();
 
         array_type ary(list.begin(), list.end());
         assigner(this->array_, std::move(ary));
@@ -876,7 +892,7 @@ class basic_value
         >::value, std::nullptr_t>::type = nullptr>
     basic_value(const T& list)
         : type_(value_t::array),
-          region_info_(std::make_shared<region_base>(region_base{}))
+          region_info_(detail::no_region())
     {
         static_assert(std::is_convertible<typename T::value_type, value_type>::value,
             "elements of a container should be convertible to toml::value");
@@ -891,7 +907,7 @@ class basic_value
         >::value, std::nullptr_t>::type = nullptr>
     basic_value(const T& list, std::vector<std::string> com)
         : type_(value_t::array),
-          region_info_(std::make_shared<region_base>(region_base{})),
+          region_info_(detail::no_region()),
           comments_(std::move(com))
     {
         static_assert(std::is_convertible<typename T::value_type, value_type>::value,
@@ -912,7 +928,7 @@ class basic_value
 
         this->cleanup();
         this->type_ = value_t::array;
-        this->region_info_ = std::make_shared<region_base>(region_base{});
+        this->region_info_ = detail::no_region();
 
         array_type ary(list.size());
         std::copy(list.begin(), list.end(), ary.begin());
@@ -924,13 +940,13 @@ class basic_value
 
     basic_value(const table_type& tab)
         : type_(value_t::table),
-          region_info_(std::make_shared<region_base>(region_base{}))
+          region_info_(detail::no_region())
     {
         assigner(this->table_, tab);
     }
     basic_value(const table_type& tab, std::vector<std::string> com)
         : type_(value_t::table),
-          region_info_(std::make_shared<region_base>(region_base{})),
+          region_info_(detail::no_region()),
           comments_(std::move(com))
     {
         assigner(this->table_, tab);
@@ -939,7 +955,7 @@ class basic_value
     {
         this->cleanup();
         this->type_ = value_t::table;
-        this->region_info_ = std::make_shared<region_base>(region_base{});
+        this->region_info_ = detail::no_region();
         assigner(this->table_, tab);
         return *this;
     }
@@ -948,7 +964,7 @@ class basic_value
 
     basic_value(std::initializer_list<std::pair<key, basic_value>> list)
         : type_(value_t::table),
-          region_info_(std::make_shared<region_base>(region_base{}))
+          region_info_(detail::no_region())
     {
         table_type tab;
         for(const auto& elem : list) {tab[elem.first] = elem.second;}
@@ -958,7 +974,7 @@ class basic_value
     basic_value(std::initializer_list<std::pair<key, basic_value>> list,
                 std::vector<std::string> com)
         : type_(value_t::table),
-          region_info_(std::make_shared<region_base>(region_base{})),
+          region_info_(detail::no_region()),
           comments_(std::move(com))
     {
         table_type tab;
@@ -969,7 +985,7 @@ class basic_value
     {
         this->cleanup();
         this->type_ = value_t::table;
-        this->region_info_ = std::make_shared<region_base>(region_base{});
+        this->region_info_ = detail::no_region();
 
         table_type tab;
         for(const auto& elem : list) {tab[elem.first] = elem.second;}
@@ -985,7 +1001,7 @@ class basic_value
         >::value, std::nullptr_t>::type = nullptr>
     basic_value(const Map& mp)
         : type_(value_t::table),
-          region_info_(std::make_shared<region_base>(region_base{}))
+          region_info_(detail::no_region())
     {
         table_type tab;
         for(const auto& elem : mp) {tab[elem.first] = elem.second;}
@@ -997,7 +1013,7 @@ class basic_value
         >::value, std::nullptr_t>::type = nullptr>
     basic_value(const Map& mp, std::vector<std::string> com)
         : type_(value_t::table),
-          region_info_(std::make_shared<region_base>(region_base{})),
+          region_info_(detail::no_region()),
           comments_(std::move(com))
     {
         table_type tab;
@@ -1012,7 +1028,7 @@ class basic_value
     {
         this->cleanup();
         this->type_ = value_t::table;
-        this->region_info_ = std::make_shared<region_base>(region_base{});
+        this->region_info_ = detail::no_region();
 
         table_type tab;
         for(const auto& elem : mp) {tab[elem.first] = elem.second;}
@@ -1062,7 +1078,7 @@ class basic_value
 
     basic_value(boolean b, detail::region reg, std::vector<std::string> cm)
         : type_(value_t::boolean),
-          region_info_(std::make_shared<detail::region>(std::move(reg))),
+          region_info_(detail::make_region(std::move(reg))),
           comments_(std::move(cm))
     {
         assigner(this->boolean_, b);
@@ -1073,7 +1089,7 @@ class basic_value
         >::value, std::nullptr_t>::type = nullptr>
     basic_value(T i, detail::region reg, std::vector<std::string> cm)
         : type_(value_t::integer),
-          region_info_(std::make_shared<detail::region>(std::move(reg))),
+          region_info_(detail::make_region(std::move(reg))),
           comments_(std::move(cm))
     {
         assigner(this->integer_, static_cast<integer>(i));
@@ -1082,7 +1098,7 @@ class basic_value
         std::is_floating_point<T>::value, std::nullptr_t>::type = nullptr>
     basic_value(T f, detail::region reg, std::vector<std::string> cm)
         : type_(value_t::floating),
-          region_info_(std::make_shared<detail::region>(std::move(reg))),
+          region_info_(detail::make_region(std::move(reg))),
           comments_(std::move(cm))
     {
         assigner(this->floating_, static_cast<floating>(f));
@@ -1090,7 +1106,7 @@ class basic_value
     basic_value(toml::string s, detail::region reg,
                 std::vector<std::string> cm)
         : type_(value_t::string),
-          region_info_(std::make_shared<detail::region>(std::move(reg))),
+          region_info_(detail::make_region(std::move(reg))),
           comments_(std::move(cm))
     {
         assigner(this->string_, std::move(s));
@@ -1098,7 +1114,7 @@ class basic_value
     basic_value(const local_date& ld, detail::region reg,
                 std::vector<std::string> cm)
         : type_(value_t::local_date),
-          region_info_(std::make_shared<detail::region>(std::move(reg))),
+          region_info_(detail::make_region(std::move(reg))),
           comments_(std::move(cm))
     {
         assigner(this->local_date_, ld);
@@ -1106,7 +1122,7 @@ class basic_value
     basic_value(const local_time& lt, detail::region reg,
                 std::vector<std::string> cm)
         : type_(value_t::local_time),
-          region_info_(std::make_shared<detail::region>(std::move(reg))),
+          region_info_(detail::make_region(std::move(reg))),
           comments_(std::move(cm))
     {
         assigner(this->local_time_, lt);
@@ -1114,7 +1130,7 @@ class basic_value
     basic_value(const local_datetime& ldt, detail::region reg,
                 std::vector<std::string> cm)
         : type_(value_t::local_datetime),
-          region_info_(std::make_shared<detail::region>(std::move(reg))),
+          region_info_(detail::make_region(std::move(reg))),
           comments_(std::move(cm))
     {
         assigner(this->local_datetime_, ldt);
@@ -1122,7 +1138,7 @@ class basic_value
     basic_value(const offset_datetime& odt, detail::region reg,
                 std::vector<std::string> cm)
         : type_(value_t::offset_datetime),
-          region_info_(std::make_shared<detail::region>(std::move(reg))),
+          region_info_(detail::make_region(std::move(reg))),
           comments_(std::move(cm))
     {
         assigner(this->offset_datetime_, odt);
@@ -1130,7 +1146,7 @@ class basic_value
     basic_value(const array_type& ary, detail::region reg,
                 std::vector<std::string> cm)
         : type_(value_t::array),
-          region_info_(std::make_shared<detail::region>(std::move(reg))),
+          region_info_(detail::make_region(std::move(reg))),
           comments_(std::move(cm))
     {
         assigner(this->array_, ary);
@@ -1138,7 +1154,7 @@ class basic_value
     basic_value(const table_type& tab, detail::region reg,
                 std::vector<std::string> cm)
         : type_(value_t::table),
-          region_info_(std::make_shared<detail::region>(std::move(reg))),
+          region_info_(detail::make_region(std::move(reg))),
           comments_(std::move(cm))
     {
         assigner(this->table_, tab);
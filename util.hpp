@@ -1,10 +1,861 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
 #include <memory>
+#include <mutex>
 #include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
 #include <vector>
+#ifdef __SSE2__
+    #include <emmintrin.h>
+#endif
+#ifdef _WIN32
+    #include <process.h>
+#else
+    #include <errno.h>
+    #include <spawn.h>
+    #include <sys/wait.h>
+    #include <unistd.h>
+
+extern char** environ;
+#endif
+
+inline std::string_view trim(std::string_view str) {
+    size_t begin = str.find_first_not_of(" \t\r\n");
+    if (begin == std::string_view::npos) {
+        return {};
+    }
+    return str.substr(begin, str.find_last_not_of(" \t\r\n") - begin + 1);
+}
+
+// Splits a command line into words the way a POSIX shell would, handling quotes and backslashes but nothing else
+inline std::vector<std::string> split_shell_words(std::string_view command) {
+    std::vector<std::string> ret;
+    std::string word;
+    bool in_word = false;
+    for (size_t i = 0; i < command.size(); ++i) {
+        char c = command[i];
+        if (c == ' ' || c == '\t' || c == '\n') {
+            if (in_word) {
+                ret.push_back(std::move(word));
+                word.clear();
+                in_word = false;
+            }
+            continue;
+        }
+
+        in_word = true;
+        if (c == '\\' && i + 1 < command.size()) {
+            word.push_back(command[++i]);
+        } else if (c == '\'') {
+            size_t end = std::min(command.find('\'', i + 1), command.size());
+            word.append(command.substr(i + 1, end - i - 1));
+            i = end;
+        } else if (c == '"') {
+            for (++i; i < command.size() && command[i] != '"'; ++i) {
+                if (command[i] == '\\' && i + 1 < command.size() && std::string_view("\"\\$`").find(command[i + 1]) != std::string_view::npos) {
+                    ++i;
+                }
+                word.push_back(command[i]);
+            }
+        } else {
+            word.push_back(c);
+        }
+    }
+    if (in_word) {
+        ret.push_back(std::move(word));
+    }
+    return ret;
+}
+
+// Runs a shell command and returns what it wrote to stdout, with newlines turned into spaces like a shell's `command` substitution would
+inline std::string capture_output(const std::string& command) {
+#ifdef _WIN32
+    FILE* pipe = _popen(command.c_str(), "r");
+#else
+    FILE* pipe = popen(command.c_str(), "r");
+#endif
+    if (!pipe) {
+        return {};
+    }
+
+    std::string ret;
+    char buf[4096];
+    for (size_t size; (size = fread(buf, 1, sizeof buf, pipe));) {
+        ret.append(buf, size);
+    }
+#ifdef _WIN32
+    _pclose(pipe);
+#else
+    pclose(pipe);
+#endif
+
+    std::replace(ret.begin(), ret.end(), '\r', ' ');
+    std::replace(ret.begin(), ret.end(), '\n', ' ');
+    return std::string(trim(ret));
+}
+
+// Runs a program found on PATH with the given arguments, without going through a shell, and waits for it to exit
+// Returns the program's exit status, or -1 if it couldn't be started
+inline int run_process(const std::vector<std::string>& arguments) {
+    if (arguments.empty()) {
+        return -1;
+    }
+
+#ifdef _WIN32
+    // _spawnvp joins its arguments with spaces, so each one has to be quoted the way the C runtime will parse it back
+    std::vector<std::string> quoted_arguments;
+    for (const auto& argument : arguments) {
+        if (!argument.empty() && argument.find_first_of(" \t\"") == std::string::npos) {
+            quoted_arguments.push_back(argument);
+            continue;
+        }
+
+        std::string quoted_argument = "\"";
+        size_t backslashes = 0;
+        for (char c : argument) {
+            if (c == '\\') {
+                ++backslashes;
+            } else {
+                if (c == '"') {
+                    quoted_argument.append(backslashes + 1, '\\');
+                }
+                backslashes = 0;
+            }
+            quoted_argument.push_back(c);
+        }
+        quoted_argument.append(backslashes, '\\');
+        quoted_argument.push_back('"');
+        quoted_arguments.push_back(std::move(quoted_argument));
+    }
+
+    std::vector<const char*> argv;
+    for (const auto& argument : quoted_arguments) {
+        argv.push_back(argument.c_str());
+    }
+    argv.push_back(nullptr);
+    return (int) _spawnvp(_P_WAIT, arguments[0].c_str(), argv.data());
+#else
+    std::vector<char*> argv;
+    for (const auto& argument : arguments) {
+        argv.push_back((char*) argument.c_str());
+    }
+    argv.push_back(nullptr);
+
+    pid_t pid;
+    if (posix_spawnp(&pid, argv[0], nullptr, nullptr, argv.data(), environ) != 0) {
+        return -1;
+    }
+
+    int status;
+    while (waitpid(pid, &status, 0) == -1) {
+        if (errno != EINTR) {
+            return -1;
+        }
+    }
+    if (WIFEXITED(status)) {
+        return WEXITSTATUS(status);
+    } else {
+        return 128 + WTERMSIG(status);
+    }
+#endif
+}
+
+// Runs a command through the system's shell and waits for it to exit
+inline int run_shell_command(const std::string& command) {
+#ifdef _WIN32
+    return run_process({"cmd", "/c", command});
+#else
+    return run_process({"/bin/sh", "-c", command});
+#endif
+}
+
+inline std::string json_escape(std::string_view str) {
+    std::string ret;
+    ret.reserve(str.size() + 2);
+    ret.push_back('"');
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            ret.push_back('\\');
+            ret.push_back(c);
+        } else if ((unsigned char) c < 0x20) {
+            static constexpr char hex_digits[] = "0123456789abcdef";
+            ret += "\\u00";
+            ret.push_back(hex_digits[(c >> 4) & 0xf]);
+            ret.push_back(hex_digits[c & 0xf]);
+        } else {
+            ret.push_back(c);
+        }
+    }
+    ret.push_back('"');
+    return ret;
+}
+
+// 64-bit FNV-1a, used for fingerprinting file contents
+inline uint64_t hash_bytes(std::string_view data, uint64_t seed = 0xcbf29ce484222325) {
+    uint64_t ret = seed;
+    for (unsigned char c : data) {
+        ret = (ret ^ c) * 0x100000001b3;
+    }
+    return ret;
+}
+
+inline std::string read_file(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return {};
+    }
+
+    file.seekg(0, std::ios::end);
+    std::streamoff size = file.tellg();
+    if (size < 0) {
+        return {};
+    }
+    std::string ret(size, '\0');
+    file.seekg(0, std::ios::beg);
+    file.read(ret.data(), ret.size());
+    ret.resize(file.gcount());
+    return ret;
+}
+
+// Returns a temporary path next to a file, like path.1234.0.tmp, that no other thread or process will use
+inline std::filesystem::path unique_temp_path(const std::filesystem::path& path) {
+    static std::atomic<unsigned long> counter(0);
+#ifdef _WIN32
+    unsigned long pid = _getpid();
+#else
+    unsigned long pid = getpid();
+#endif
+    std::filesystem::path ret = path;
+    ret += '.' + std::to_string(pid) + '.' + std::to_string(counter++) + ".tmp";
+    return ret;
+}
+
+// Replaces the contents of a file by writing to a temporary file and renaming it over the original
+inline bool write_file_atomically(const std::filesystem::path& path, std::string_view contents) {
+    std::filesystem::path temp_path = unique_temp_path(path);
+
+    std::ofstream file(temp_path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    file.write(contents.data(), contents.size());
+    file.close();
+    if (!file) {
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temp_path, path, ec);
+    if (ec) {
+        std::filesystem::remove(temp_path, ec);
+        return false;
+    }
+    return true;
+}
+
+// Writes a file only if its contents would change, so that its modification time is left alone otherwise
+// Returns true if the file was written, and throws std::filesystem::filesystem_error if writing it failed
+inline bool write_file_if_changed(const std::filesystem::path& path, std::string_view contents) {
+    std::error_code ec;
+    if (std::filesystem::is_regular_file(path, ec) && std::filesystem::file_size(path, ec) == contents.size() && read_file(path) == contents) {
+        return false;
+    }
+    if (!write_file_atomically(path, contents)) {
+        throw std::filesystem::filesystem_error("Failed to write file", path, std::make_error_code(std::errc::io_error));
+    }
+    return true;
+}
+
+// A stream buffer that compares everything written to it with a file's contents as it arrives, without holding either in memory
+// Nothing is written to disk until the two differ, at which point the matching part is copied to a temporary file that the rest goes to, and commit() renames it over the original
+class FileUpdateBuffer: public std::streambuf {
+public:
+    FileUpdateBuffer(std::filesystem::path path):
+        path(std::move(path)),
+        existing_file(this->path, std::ios::binary),
+        buffer(1 << 16),
+        existing_buffer(buffer.size()) {
+        setp(buffer.data(), buffer.data() + buffer.size());
+    }
+    FileUpdateBuffer(const FileUpdateBuffer&) = delete;
+    FileUpdateBuffer& operator=(const FileUpdateBuffer&) = delete;
+    ~FileUpdateBuffer() {
+        if (temp_file.is_open()) {
+            temp_file.close();
+            std::error_code ec;
+            std::filesystem::remove(temp_path, ec);
+        }
+    }
+
+    // Returns true if the file was written, and throws std::filesystem::filesystem_error if writing it failed
+    bool commit() {
+        if (has_failed || !flush_buffer()) {
+            fail();
+        }
+        if (!temp_file.is_open()) {
+            if (existing_file.is_open() && existing_file.peek() == std::char_traits<char>::eof()) {
+                return false;
+            }
+            if (!start_writing()) {
+                fail();
+            }
+        }
+
+        temp_file.close();
+        std::error_code ec;
+        if (!temp_file || (std::filesystem::rename(temp_path, path, ec), ec)) {
+            fail();
+        }
+        return true;
+    }
+
+protected:
+    int overflow(int c) override {
+        if (has_failed || !flush_buffer()) {
+            has_failed = true;
+            return traits_type::eof();
+        }
+        if (c != traits_type::eof()) {
+            *pptr() = (char) c;
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+
+private:
+    std::filesystem::path path;
+    std::filesystem::path temp_path;
+    std::ifstream existing_file;
+    std::ofstream temp_file;
+    std::vector<char> buffer;
+    std::vector<char> existing_buffer;
+    size_t matching_size = 0; // How much of the file matched before the two differed
+    bool has_failed = false;
+
+    bool flush_buffer() {
+        size_t size = pptr() - pbase();
+        setp(buffer.data(), buffer.data() + buffer.size());
+        if (!temp_file.is_open()) {
+            if (existing_file.is_open() && existing_file.read(existing_buffer.data(), size) && memcmp(existing_buffer.data(), buffer.data(), size) == 0) {
+                matching_size += size;
+                return true;
+            }
+            if (!start_writing()) {
+                return false;
+            }
+        }
+        return (bool) temp_file.write(buffer.data(), size);
+    }
+
+    // Opens the temporary file and copies the part of the file that matched into it
+    bool start_writing() {
+        temp_path = unique_temp_path(path);
+        temp_file.open(temp_path, std::ios::binary);
+        if (!temp_file.is_open()) {
+            return false;
+        }
+        if (matching_size) {
+            existing_file.clear();
+            existing_file.seekg(0);
+            for (size_t copied = 0; copied < matching_size;) {
+                size_t size = std::min(matching_size - copied, existing_buffer.size());
+                if (!existing_file.read(existing_buffer.data(), size) || !temp_file.write(existing_buffer.data(), size)) {
+                    return false;
+                }
+                copied += size;
+            }
+        }
+        existing_file.close();
+        return true;
+    }
+
+    [[noreturn]] void fail() {
+        throw std::filesystem::filesystem_error("Failed to write file", path, std::make_error_code(std::errc::io_error));
+    }
+};
+
+// Like write_file_if_changed, but for files too large to build in memory, whose contents are written to the stream passed to write instead
+inline bool write_file_if_changed(const std::filesystem::path& path, const std::function<void(std::ostream&)>& write) {
+    FileUpdateBuffer buffer(path);
+    std::ostream os(&buffer);
+    write(os);
+    return buffer.commit();
+}
+
+// Matches a path against a glob pattern
+// * and ? match any characters except slashes, while ** also matches slashes, and **/ may match nothing at all
+inline bool glob_match(std::string_view pattern, std::string_view str) {
+    while (!pattern.empty()) {
+        if (pattern.substr(0, 2) == "**") {
+            pattern.remove_prefix(2);
+            if (!pattern.empty() && pattern.front() == '/' && glob_match(pattern.substr(1), str)) {
+                return true;
+            }
+            for (size_t i = 0; i <= str.size(); ++i) {
+                if (glob_match(pattern, str.substr(i))) {
+                    return true;
+                }
+            }
+            return false;
+        } else if (pattern.front() == '*') {
+            pattern.remove_prefix(1);
+            for (size_t i = 0;; ++i) {
+                if (glob_match(pattern, str.substr(i))) {
+                    return true;
+                } else if (i == str.size() || str[i] == '/') {
+                    return false;
+                }
+            }
+        } else if (str.empty() || (pattern.front() == '?' ? str.front() == '/' : pattern.front() != str.front())) {
+            return false;
+        }
+        pattern.remove_prefix(1);
+        str.remove_prefix(1);
+    }
+    return str.empty();
+}
+
+struct IncludeDirective {
+    std::string name;
+    bool is_angled;
+};
+
+// Finds the #include directives in C/C++ source code without running the preprocessor
+// Comments, string literals, and line continuations are skipped so that only real directives are reported
+inline void scan_includes(std::string_view source, std::vector<IncludeDirective>& ret) {
+    auto is_horizontal_space = [](char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v';
+    };
+    auto is_identifier_char = [](char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+    };
+
+    const char* const begin = source.data();
+    const char* const end = begin + source.size();
+    const char* it = begin;
+
+    // Characters that can change the state of the scanner once it is past the start of a line
+    static constexpr auto is_special = []() {
+        std::array<bool, 256> ret {};
+        for (unsigned char c : {'\n', '/', '"', '\'', '\\'}) {
+            ret[c] = true;
+        }
+        return ret;
+    }();
+    // Skips to the next special character, comparing 16 bytes at a time where SSE2 is available
+    auto find_special = [end](const char* it) {
+#ifdef __SSE2__
+        const __m128i newline = _mm_set1_epi8('\n');
+        const __m128i slash = _mm_set1_epi8('/');
+        const __m128i double_quote = _mm_set1_epi8('"');
+        const __m128i single_quote = _mm_set1_epi8('\'');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        for (; end - it >= 16; it += 16) {
+            __m128i chunk = _mm_loadu_si128((const __m128i*) it);
+            __m128i matches = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, newline), _mm_cmpeq_epi8(chunk, slash)),
+                _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, double_quote), _mm_cmpeq_epi8(chunk, single_quote)), _mm_cmpeq_epi8(chunk, backslash)));
+            if (int mask = _mm_movemask_epi8(matches)) {
+                return it + __builtin_ctz(mask);
+            }
+        }
+#endif
+        while (it < end && !is_special[(unsigned char) *it]) ++it;
+        return it;
+    };
+
+    auto skip_line_continuation = [&]() {
+        if (it + 1 < end && it[1] == '\n') {
+            it += 2;
+            return true;
+        } else if (it + 2 < end && it[1] == '\r' && it[2] == '\n') {
+            it += 3;
+            return true;
+        }
+        return false;
+    };
+    auto skip_horizontal_space = [&]() {
+        while (it < end) {
+            if (is_horizontal_space(*it)) {
+                ++it;
+            } else if (*it != '\\' || !skip_line_continuation()) {
+                break;
+            }
+        }
+    };
+
+    bool at_line_start = true;
+    while (it < end) {
+        char c = *it;
+        if (c == '\n') {
+            at_line_start = true;
+            ++it;
+        } else if (is_horizontal_space(c)) {
+            ++it;
+        } else if (c == '\\' && skip_line_continuation()) {
+            continue;
+        } else if (c == '/' && it + 1 < end && it[1] == '*') {
+            // Block comments count as whitespace
+            it += 2;
+            for (;;) {
+                const char* star = (const char*) memchr(it, '*', end - it);
+                if (!star || star + 1 >= end) {
+                    it = end;
+                    break;
+                } else if (star[1] == '/') {
+                    it = star + 2;
+                    break;
+                }
+                it = star + 1;
+            }
+        } else if (c == '/' && it + 1 < end && it[1] == '/') {
+            // Line comments end at the first newline that isn't escaped
+            for (;;) {
+                const char* newline = (const char*) memchr(it, '\n', end - it);
+                if (!newline) {
+                    it = end;
+                    break;
+                }
+                const char* last = newline - 1;
+                if (*last == '\r') --last;
+                it = newline;
+                if (*last != '\\') break;
+                ++it;
+            }
+        } else if (c == '#' && at_line_start) {
+            at_line_start = false;
+            ++it;
+            skip_horizontal_space();
+
+            static constexpr std::string_view include_keyword = "include";
+            if (std::string_view(it, std::min<size_t>(end - it, include_keyword.size())) != include_keyword) continue;
+            it += include_keyword.size();
+            if (it < end && is_identifier_char(*it)) continue; // e.g. #include_next
+            skip_horizontal_space();
+
+            if (it < end && (*it == '<' || *it == '"')) {
+                char terminator = *it == '<' ? '>' : '"';
+                const char* name_begin = ++it;
+                while (it < end && *it != terminator && *it != '\n') ++it;
+                if (it < end && *it == terminator) {
+                    if (it != name_begin) {
+                        ret.push_back({std::string(name_begin, it), terminator == '>'});
+                    }
+                    ++it;
+                }
+            }
+        } else if (c == '"') {
+            at_line_start = false;
+
+            // Check for a raw string literal prefix (R, LR, uR, UR, or u8R)
+            const char* prefix_begin = it;
+            while (prefix_begin != begin && is_identifier_char(prefix_begin[-1])) --prefix_begin;
+            std::string_view prefix(prefix_begin, it - prefix_begin);
+            if (prefix == "R" || prefix == "LR" || prefix == "uR" || prefix == "UR" || prefix == "u8R") {
+                const char* delimiter_end = (const char*) memchr(it, '(', std::min<size_t>(end - it, 18));
+                if (delimiter_end) {
+                    std::string terminator = ')' + std::string(it + 1, delimiter_end) + '"';
+                    size_t terminator_pos = source.find(terminator, delimiter_end - begin);
+                    it = terminator_pos == std::string_view::npos ? end : begin + terminator_pos + terminator.size();
+                    continue;
+                }
+            }
+
+            // Ordinary string literals end at the closing quote or at an unescaped newline
+            for (++it; it < end && *it != '"' && *it != '\n'; ++it) {
+                if (*it == '\\' && it + 1 < end) ++it;
+            }
+            if (it < end && *it == '"') ++it;
+        } else if (c == '\'') {
+            at_line_start = false;
+
+            // A single quote after a digit or identifier is a digit separator (e.g. 1'000'000)
+            if (it != begin && is_identifier_char(it[-1])) {
+                ++it;
+                continue;
+            }
+
+            for (++it; it < end && *it != '\'' && *it != '\n'; ++it) {
+                if (*it == '\\' && it + 1 < end) ++it;
+            }
+            if (it < end && *it == '\'') ++it;
+        } else {
+            at_line_start = false;
+            it = find_special(it + 1);
+        }
+    }
+}
+
+// Reads the headers listed in a depfile written by MSVC's /sourceDependencies option, which looks like
+// {"Version": "1.1", "Data": {"Source": "...", "Includes": ["...", ...], ...}}
+inline std::vector<std::filesystem::path> read_json_depfile(std::string_view depfile) {
+    std::vector<std::filesystem::path> ret;
+    size_t i = depfile.find("\"Includes\"");
+    if (i == std::string_view::npos || (i = depfile.find_first_not_of(" \t\r\n", i + 10)) == std::string_view::npos || depfile[i] != ':' ||
+        (i = depfile.find_first_not_of(" \t\r\n", i + 1)) == std::string_view::npos || depfile[i] != '[') {
+        return ret;
+    }
+
+    auto parse_hex = [&depfile](size_t i) -> long {
+        if (i + 4 > depfile.size()) {
+            return -1;
+        }
+        long ret = 0;
+        for (size_t j = i; j < i + 4; ++j) {
+            char c = depfile[j];
+            ret <<= 4;
+            if (c >= '0' && c <= '9') {
+                ret |= c - '0';
+            } else if (c >= 'a' && c <= 'f') {
+                ret |= c - 'a' + 10;
+            } else if (c >= 'A' && c <= 'F') {
+                ret |= c - 'A' + 10;
+            } else {
+                return -1;
+            }
+        }
+        return ret;
+    };
+
+    while ((i = depfile.find_first_not_of(" \t\r\n,", i + 1)) != std::string_view::npos && depfile[i] == '"') {
+        std::string include;
+        for (++i; i < depfile.size() && depfile[i] != '"'; ++i) {
+            if (depfile[i] != '\\') {
+                include.push_back(depfile[i]);
+                continue;
+            } else if (++i == depfile.size()) {
+                return ret;
+            }
+
+            if (char c = depfile[i]; c == 'u') {
+                long code_point = parse_hex(i + 1);
+                if (code_point < 0) {
+                    return ret;
+                }
+                i += 4;
+                if (code_point >= 0xd800 && code_point < 0xdc00 && i + 2 < depfile.size() && depfile[i + 1] == '\\' && depfile[i + 2] == 'u') {
+                    if (long low_surrogate = parse_hex(i + 3); low_surrogate >= 0xdc00 && low_surrogate < 0xe000) {
+                        code_point = 0x10000 + ((code_point - 0xd800) << 10) + (low_surrogate - 0xdc00);
+                        i += 6;
+                    }
+                }
+
+                // Encodes the code point as UTF-8
+                if (code_point < 0x80) {
+                    include.push_back(code_point);
+                } else if (code_point < 0x800) {
+                    include.push_back(0xc0 | (code_point >> 6));
+                    include.push_back(0x80 | (code_point & 0x3f));
+                } else if (code_point < 0x10000) {
+                    include.push_back(0xe0 | (code_point >> 12));
+                    include.push_back(0x80 | ((code_point >> 6) & 0x3f));
+                    include.push_back(0x80 | (code_point & 0x3f));
+                } else {
+                    include.push_back(0xf0 | (code_point >> 18));
+                    include.push_back(0x80 | ((code_point >> 12) & 0x3f));
+                    include.push_back(0x80 | ((code_point >> 6) & 0x3f));
+                    include.push_back(0x80 | (code_point & 0x3f));
+                }
+            } else if (size_t escape = std::string_view("bfnrt").find(c); escape != std::string_view::npos) {
+                include.push_back("\b\f\n\r\t"[escape]);
+            } else {
+                include.push_back(c); // \", \\, or \/
+            }
+        }
+        if (i == depfile.size()) {
+            break;
+        }
+        ret.push_back(std::filesystem::u8path(include));
+    }
+    return ret;
+}
+
+// Reads the prerequisites of the first rule in a depfile written by a compiler's -MMD option, or the headers in one written by MSVC's /sourceDependencies option
+inline std::vector<std::filesystem::path> read_depfile(const std::filesystem::path& path) {
+    std::string depfile = read_file(path);
+    if (path.extension() == ".json") {
+        return read_json_depfile(depfile);
+    }
+
+    std::vector<std::filesystem::path> ret;
+    std::string word;
+    bool past_target = false;
+    for (size_t i = 0; i < depfile.size(); ++i) {
+        char c = depfile[i];
+        if (c == '\\' && i + 1 < depfile.size() && (depfile[i + 1] == '\n' || depfile[i + 1] == '\r')) {
+            i += depfile[i + 1] == '\r' && i + 2 < depfile.size() && depfile[i + 2] == '\n' ? 2 : 1;
+            c = ' ';
+        } else if (c == '\\' && i + 1 < depfile.size() && (depfile[i + 1] == ' ' || depfile[i + 1] == '#')) {
+            word.push_back(depfile[++i]);
+            continue;
+        } else if (c == '$' && i + 1 < depfile.size() && depfile[i + 1] == '$') {
+            word.push_back(depfile[++i]);
+            continue;
+        } else if (c == ':' && !past_target && (i + 1 == depfile.size() || std::string_view(" \t\r\n").find(depfile[i + 1]) != std::string_view::npos)) {
+            word.clear();
+            past_target = true;
+            continue;
+        }
+
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+            if (past_target && !word.empty()) {
+                ret.push_back(word);
+            }
+            word.clear();
+            if (c == '\n' && past_target) {
+                break;
+            }
+        } else {
+            word.push_back(c);
+        }
+    }
+    if (past_target && !word.empty()) {
+        ret.push_back(word);
+    }
+    return ret;
+}
+
+// A fixed set of worker threads, each with its own task queue
+// Tasks scheduled from inside a worker go to that worker's queue, and idle workers steal from the others
+// Tasks scheduled from outside the pool are started in the order they were scheduled
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned int size = std::thread::hardware_concurrency()) {
+        size = std::max(size, 1u);
+        for (unsigned int i = 0; i < size; ++i) {
+            queues.push_back(std::make_unique<Queue>());
+        }
+        for (unsigned int i = 0; i < size; ++i) {
+            threads.emplace_back(&ThreadPool::run, this, i);
+        }
+    }
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        task_available.notify_all();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    size_t size() const {
+        return threads.size();
+    }
+
+    void schedule(std::function<void()> task) {
+        Queue& queue = current_pool == this ? *queues[current_index] : injector;
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(std::move(task));
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++queued;
+            ++pending;
+        }
+        task_available.notify_one();
+    }
+
+    // Blocks until every scheduled task has finished, rethrowing the first exception thrown by a task
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        tasks_finished.wait(lock, [this]() {
+            return pending == 0;
+        });
+        if (exception) {
+            std::rethrow_exception(std::exchange(exception, nullptr));
+        }
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    Queue injector; // Tasks scheduled from outside the pool
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable task_available;
+    std::condition_variable tasks_finished;
+    size_t queued = 0;  // Tasks sitting in a queue
+    size_t pending = 0; // Tasks that haven't finished yet
+    bool stopping = false;
+    std::exception_ptr exception;
+
+    static inline thread_local ThreadPool* current_pool = nullptr;
+    static inline thread_local size_t current_index = 0;
+
+    void run(size_t index) {
+        current_pool = this;
+        current_index = index;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                task_available.wait(lock, [this]() {
+                    return queued || stopping;
+                });
+                if (!queued) {
+                    return;
+                }
+                --queued; // Reserves one of the queued tasks for this worker
+            }
+
+            // Take the newest task from this worker's queue, or else the oldest task from outside the pool or from another worker's queue
+            std::function<void()> task;
+            for (size_t i = 0; !task; i = (i + 1) % (queues.size() + 1)) {
+                Queue& queue = i == 0 ? *queues[index] : (i == 1 ? injector : *queues[(index + i - 1) % queues.size()]);
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                if (!queue.tasks.empty()) {
+                    if (i == 0) {
+                        task = std::move(queue.tasks.back());
+                        queue.tasks.pop_back();
+                    } else {
+                        task = std::move(queue.tasks.front());
+                        queue.tasks.pop_front();
+                    }
+                }
+            }
+
+            std::exception_ptr task_exception;
+            try {
+                task();
+            } catch (...) {
+                task_exception = std::current_exception();
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (task_exception && !exception) {
+                exception = task_exception;
+            }
+            if (!--pending) {
+                tasks_finished.notify_all();
+            }
+        }
+    }
+};
 
 class SortedDirectoryIterator {
 public:
@@ -19,14 +870,15 @@ public:
         SortedDirectoryIterator(path, std::filesystem::directory_options::none) {}
     SortedDirectoryIterator(const std::filesystem::path& path, std::filesystem::directory_options options):
         entries(std::make_shared<std::vector<std::filesystem::directory_entry>>()) {
+        std::vector<std::pair<std::string, std::filesystem::directory_entry>> keyed_entries;
         if (std::filesystem::is_regular_file(path)) {
-            entries->push_back(std::filesystem::directory_entry(path));
+            keyed_entries.emplace_back(path.filename().string(), std::filesystem::directory_entry(path));
         } else {
             for (const auto& entry : std::filesystem::directory_iterator(path, options)) {
-                entries->push_back(entry);
+                keyed_entries.emplace_back(entry.path().filename().string(), entry);
             }
         }
-        init();
+        init(std::move(keyed_entries));
     }
     SortedDirectoryIterator(const std::filesystem::path& path, std::error_code& ec) noexcept:
         SortedDirectoryIterator(path, std::filesystem::directory_options::none, ec) {}
@@ -34,14 +886,59 @@ public:
         entries(std::make_shared<std::vector<std::filesystem::directory_entry>>()) {
         std::filesystem::directory_iterator it(path, options, ec);
         if (!ec) {
+            std::vector<std::pair<std::string, std::filesystem::directory_entry>> keyed_entries;
             for (const auto& entry : it) {
-                entries->push_back(entry);
+                keyed_entries.emplace_back(entry.path().filename().string(), entry);
             }
-            init();
+            init(std::move(keyed_entries));
         } else {
             entries = nullptr; // Act as an end iterator on failure
         }
     }
+    // Lists path, or the whole tree under it if recursive is true, reading directories in parallel on pool
+    // Entries whose paths match one of ignore_patterns are skipped, along with everything under them
+    // In recursive mode, directories aren't listed themselves, and entries are sorted by their path relative to path
+    SortedDirectoryIterator(const std::filesystem::path& path, bool recursive, const std::vector<std::string>& ignore_patterns, ThreadPool& pool):
+        entries(std::make_shared<std::vector<std::filesystem::directory_entry>>()) {
+        auto is_ignored = [&ignore_patterns](const std::filesystem::path& path) {
+            std::string generic_path = path.lexically_normal().generic_string();
+            return std::any_of(ignore_patterns.begin(), ignore_patterns.end(), [&generic_path](const auto& pattern) {
+                return glob_match(pattern, generic_path);
+            });
+        };
+
+        std::vector<std::pair<std::string, std::filesystem::directory_entry>> keyed_entries;
+        if (std::filesystem::is_regular_file(path)) {
+            if (!is_ignored(path)) {
+                keyed_entries.emplace_back(path.filename().string(), std::filesystem::directory_entry(path));
+            }
+        } else {
+            std::mutex mutex;
+            std::function<void(std::filesystem::path)> list_directory = [&](std::filesystem::path directory_path) {
+                std::vector<std::pair<std::string, std::filesystem::directory_entry>> directory_entries;
+                for (const auto& entry : std::filesystem::directory_iterator(directory_path)) {
+                    if (is_ignored(entry.path())) {
+                        continue;
+                    } else if (recursive && entry.is_directory() && !entry.is_symlink()) {
+                        pool.schedule([&list_directory, entry_path = entry.path()]() {
+                            list_directory(entry_path);
+                        });
+                    } else {
+                        std::string key = recursive ? entry.path().lexically_relative(path).generic_string() : entry.path().filename().string();
+                        directory_entries.emplace_back(std::move(key), entry);
+                    }
+                }
+
+                std::lock_guard<std::mutex> lock(mutex);
+                std::move(directory_entries.begin(), directory_entries.end(), std::back_inserter(keyed_entries));
+            };
+            pool.schedule([&list_directory, &path]() {
+                list_directory(path);
+            });
+            pool.wait();
+        }
+        init(std::move(keyed_entries));
+    }
 
     reference operator*() const {
         return (*entries)[cursor];
@@ -91,13 +988,17 @@ private:
     std::shared_ptr<std::vector<std::filesystem::directory_entry>> entries;
     size_t cursor = 0;
 
-    void init() {
-        if (entries->empty()) {
+    void init(std::vector<std::pair<std::string, std::filesystem::directory_entry>> keyed_entries) {
+        if (keyed_entries.empty()) {
             entries.reset(); // Instantly become an end iterator if empty
         } else {
-            std::sort(entries->begin(), entries->end(), [](const auto& a, const auto& b) {
-                return a.path().filename().string() < b.path().filename().string();
+            std::sort(keyed_entries.begin(), keyed_entries.end(), [](const auto& a, const auto& b) {
+                return a.first < b.first;
             });
+            entries->reserve(keyed_entries.size());
+            for (auto& keyed_entry : keyed_entries) {
+                entries->push_back(std::move(keyed_entry.second));
+            }
         }
     }
 };